@@ -0,0 +1,192 @@
+#include "Beachline.h"
+#include "Sweeping.h"
+
+#include <utility>
+
+namespace tora::sim::fortune {
+
+Beachline::Beachline(Beachline&& other) noexcept
+    : pool_{ std::move(other.pool_) },
+      free_{ std::move(other.free_) },
+      root_{ std::exchange(other.root_, nullptr) },
+      front_{ std::exchange(other.front_, nullptr) },
+      back_{ std::exchange(other.back_, nullptr) },
+      size_{ std::exchange(other.size_, 0) },
+      seed_{ other.seed_ }
+{
+}
+
+Beachline& Beachline::operator=(Beachline&& other) noexcept
+{
+    if (this != &other) {
+        pool_ = std::move(other.pool_);
+        free_ = std::move(other.free_);
+        root_ = std::exchange(other.root_, nullptr);
+        front_ = std::exchange(other.front_, nullptr);
+        back_ = std::exchange(other.back_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        seed_ = other.seed_;
+    }
+    return *this;
+}
+
+ArcRef Beachline::findArcAbove(Point p) const
+{
+    // lower bound on the right breakpoint, same answer as a left-to-right scan;
+    // the last arc's right breakpoint is at infinity
+    ArcRef result = back_;
+    ArcRef node = root_;
+    while (node) {
+        if (!node->next || p.x < breakpoint(node->location, node->next->location, p.y).x) {
+            result = node;
+            node = node->left;
+        }
+        else {
+            node = node->right;
+        }
+    }
+    return result;
+}
+
+ArcRef Beachline::pushBack(const Arc& arc)
+{
+    if (back_) {
+        return insertAfter(back_, arc);
+    }
+
+    auto node = allocate(arc);
+    root_ = front_ = back_ = node;
+    size_ = 1;
+    return node;
+}
+
+ArcRef Beachline::insertAfter(ArcRef pos, const Arc& arc)
+{
+    auto node = allocate(arc);
+
+    // thread into the x-ordered list
+    node->prev = pos;
+    node->next = pos->next;
+    if (pos->next) {
+        pos->next->prev = node;
+    }
+    else {
+        back_ = node;
+    }
+    pos->next = node;
+
+    // the in-order successor slot is either pos->right or the left of pos's successor
+    if (!pos->right) {
+        pos->right = node;
+        node->parent = pos;
+    }
+    else {
+        auto successor = node->next;
+        successor->left = node;
+        node->parent = successor;
+    }
+
+    while (node->parent && node->priority > node->parent->priority) {
+        rotateUp(node);
+    }
+
+    size_++;
+    return node;
+}
+
+void Beachline::erase(ArcRef arc)
+{
+    // push the node down until it has at most one child
+    while (arc->left && arc->right) {
+        rotateUp(arc->left->priority > arc->right->priority ? arc->left : arc->right);
+    }
+
+    auto child = arc->left ? arc->left : arc->right;
+    if (child) {
+        child->parent = arc->parent;
+    }
+    replaceChild(arc->parent, arc, child);
+
+    if (arc->prev) {
+        arc->prev->next = arc->next;
+    }
+    else {
+        front_ = arc->next;
+    }
+    if (arc->next) {
+        arc->next->prev = arc->prev;
+    }
+    else {
+        back_ = arc->prev;
+    }
+
+    size_--;
+    free_.push_back(arc);
+}
+
+void Beachline::clear()
+{
+    pool_.clear();
+    free_.clear();
+    root_ = front_ = back_ = nullptr;
+    size_ = 0;
+}
+
+ArcRef Beachline::allocate(const Arc& arc)
+{
+    ArcRef node;
+    if (!free_.empty()) {
+        node = free_.back();
+        free_.pop_back();
+        *node = arc;
+    }
+    else {
+        node = &pool_.emplace_back(arc);
+    }
+
+    node->prev = node->next = nullptr;
+    node->parent = node->left = node->right = nullptr;
+
+    // xorshift32, deterministic so runs are reproducible
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    node->priority = seed_;
+
+    return node;
+}
+
+void Beachline::rotateUp(ArcRef node)
+{
+    auto parent = node->parent;
+    auto grandParent = parent->parent;
+
+    if (parent->left == node) {
+        parent->left = node->right;
+        if (node->right) node->right->parent = parent;
+        node->right = parent;
+    }
+    else {
+        parent->right = node->left;
+        if (node->left) node->left->parent = parent;
+        node->left = parent;
+    }
+    parent->parent = node;
+    node->parent = grandParent;
+    replaceChild(grandParent, parent, node);
+}
+
+void Beachline::replaceChild(ArcRef parent, ArcRef oldChild, ArcRef newChild)
+{
+    if (!parent) {
+        root_ = newChild;
+    }
+    else if (parent->left == oldChild) {
+        parent->left = newChild;
+    }
+    else {
+        parent->right = newChild;
+    }
+}
+
+} // namespace tora::sim::fortune
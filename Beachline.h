@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "Geometry.h"
+
+namespace tora::sim::fortune {
+
+using namespace tora::geometry;
+
+struct Arc
+{
+    int id;
+    int site;
+    Point location; // site location!
+    int s1 = -1;
+    int s2 = -1;
+    // half-edges of this arc's cell traced by its left and right breakpoints, see Voronoi
+    int leftHalfEdge = -1;
+    int rightHalfEdge = -1;
+    int event = -1; // id of the pending vertex event, see EventQueue
+
+    // Beachline links, maintained by Beachline.
+    // prev/next thread the arcs in x order, the rest is the balanced tree.
+    Arc* prev = nullptr;
+    Arc* next = nullptr;
+    Arc* parent = nullptr;
+    Arc* left = nullptr;
+    Arc* right = nullptr;
+    uint32_t priority = 0;
+
+    inline bool isValid() const { return site >= 0; }
+};
+
+using ArcRef = Arc*;
+
+// Arcs of the beachline, ordered by x.
+// Backed by a treap whose keys are the breakpoints between neighboring arcs. Breakpoints
+// move with the sweep line, so they are never stored: they are evaluated lazily at the
+// y of the query, which keeps the in-order sequence valid without any rebalancing.
+// Lookup, insertion and removal are O(log n) expected; neighbors are O(1) via prev/next.
+class Beachline
+{
+public:
+    Beachline() = default;
+    Beachline(const Beachline&) = delete;
+    Beachline& operator=(const Beachline&) = delete;
+    Beachline(Beachline&& other) noexcept;
+    Beachline& operator=(Beachline&& other) noexcept;
+
+    bool empty() const { return root_ == nullptr; }
+    int size() const { return size_; }
+
+    // leftmost and rightmost arcs, nullptr if empty
+    ArcRef front() const { return front_; }
+    ArcRef back() const { return back_; }
+
+    // Returns the arc right above p, i.e. the first arc whose right breakpoint
+    // at y = p.y lies right of p. Returns nullptr if the beachline is empty.
+    ArcRef findArcAbove(Point p) const;
+
+    ArcRef pushBack(const Arc& arc);
+    ArcRef insertAfter(ArcRef pos, const Arc& arc);
+    void erase(ArcRef arc);
+    void clear();
+
+private:
+    ArcRef allocate(const Arc& arc);
+    void rotateUp(ArcRef node);
+    void replaceChild(ArcRef parent, ArcRef oldChild, ArcRef newChild);
+
+    // arcs live in a deque so that ArcRefs stay valid while the beachline grows
+    std::deque<Arc> pool_;
+    std::vector<ArcRef> free_;
+
+    ArcRef root_ = nullptr;
+    ArcRef front_ = nullptr;
+    ArcRef back_ = nullptr;
+    int size_ = 0;
+    uint32_t seed_ = 0x9e3779b9u;
+};
+
+} // namespace tora::sim::fortune
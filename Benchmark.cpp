@@ -0,0 +1,445 @@
+// Headless benchmarks for the Voronoi pipeline. Does not link SFML.
+//
+//     g++ -std=c++20 -O2 -DNDEBUG -o benchmark Benchmark.cpp Beachline.cpp EventQueue.cpp Sweeping.cpp
+//         Geometry.cpp DelaunayVoronoi.cpp VoronoiEngine.cpp ThreadPool.cpp PolygonSet.cpp
+//         Predicates.cpp
+//     ./benchmark --format csv --sizes 1000,10000 --reps 9
+//
+// Options:
+//     --format json|csv        output format, default json
+//     --sizes n1,n2,...        site counts, default 1000,10000,100000,1000000
+//     --distributions a,b,...  uniform, clustered, degenerate, chunks; default all four
+//     --engines a,b            fortune, delaunay; default both
+//     --reps n                 timed repetitions per case, default 5
+//     --warmup n               untimed repetitions per case, default 1
+//     --seed n                 base seed, default 42
+//
+// Every case times these phases. "items" counts the work each phase does:
+//     construct    fortune: State construction (site sorting included)
+//                  delaunay: triangulation and circumcenters; items = sites
+//     run          fortune only, State::run(), items = sweep events
+//     polygons     getPolygons(), items = cells
+//     offset       geometry::offset(cell, -1) over every cell, items = cells
+//     offset_batch geometry::offsetBatch(cells, -1) on the shared pool, items = cells
+// The "chunks" distribution times chunk-table lookups instead, for engines flat_hash
+// (FlatHashMap over GridKey::packed) and unordered_map (std::unordered_map<GridKey>):
+//     lookup       the 5x5 neighborhood of every chunk in a square block of about n
+//                  chunks, misses at the border included; items = lookups
+// When both engines run on a case their cells are compared, differences go to stderr.
+// peak_rss_kb is the process high-water mark when the case finishes. It only grows, so
+// cases run in ascending size order.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DelaunayVoronoi.h"
+#include "FlatHashMap.h"
+#include "Geometry.h"
+#include "GridKey.h"
+#include "Random.h"
+#include "Sweeping.h"
+#include "VoronoiEngine.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using namespace tora::sim::fortune;
+using tora::sim::VoronoiEngine;
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string format = "json";
+    std::vector<int> sizes{ 1000, 10000, 100000, 1000000 };
+    std::vector<std::string> distributions{ "uniform", "clustered", "degenerate", "chunks" };
+    std::vector<VoronoiEngine> engines{ VoronoiEngine::Fortune, VoronoiEngine::Delaunay };
+    int reps = 5;
+    int warmup = 1;
+    uint64_t seed = 42;
+};
+
+struct Result
+{
+    std::string engine;
+    std::string distribution;
+    int sites;
+    std::string phase;
+    int reps;
+    double medianMs;
+    double p99Ms;
+    size_t items;
+    double itemsPerSec;
+    long peakRssKb;
+};
+
+long peakRssKb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// cell corners further apart than this count as different between engines
+constexpr double kCompareTolerance = 1e-6;
+
+// keeps results alive so the optimizer cannot drop timed work
+volatile size_t sink = 0;
+
+double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double percentile(std::vector<double> samples, double p)
+{
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+    return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
+// Sites keep density constant across sizes: about one site per 10x10 square.
+// They come out in generation order, unsorted, so construction pays for the sort.
+std::vector<Site> generateSites(const std::string& distribution, int n, uint64_t seed)
+{
+    tora::Random random(seed * 0x9e3779b97f4a7c15ull + n);
+    const double side = 10.0 * std::sqrt(static_cast<double>(n));
+
+    std::vector<Site> sites;
+    sites.reserve(n);
+
+    if (distribution == "uniform") {
+        std::vector<double> coords(2 * static_cast<size_t>(n));
+        random.fill(std::span<double>(coords), 0.0, side);
+        for (int i = 0; i < n; i++) {
+            sites.push_back(Site{ .id = i, .location = Point(coords[2 * i], coords[2 * i + 1]) });
+        }
+    }
+    else if (distribution == "clustered") {
+        int numClusters = std::max(1, n / 1000);
+        double sigma = side / (4.0 * std::sqrt(static_cast<double>(numClusters)));
+        std::vector<Point> centers;
+        for (int i = 0; i < numClusters; i++) {
+            centers.push_back(Point(random.getRandomBetween(0.0, side), random.getRandomBetween(0.0, side)));
+        }
+        std::normal_distribution<double> spread(0.0, sigma);
+        for (int i = 0; i < n; i++) {
+            const auto& c = centers[random() % numClusters];
+            sites.push_back(Site{ .id = i, .location = Point(c.x + spread(random), c.y + spread(random)) });
+        }
+    }
+    else {
+        // square lattice: whole rows share a y and every cell has four co-circular sites
+        int k = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(n))));
+        for (int i = 0; i < n; i++) {
+            sites.push_back(Site{ .id = i, .location = Point((i % k) * 10.0, (i / k) * 10.0) });
+        }
+    }
+
+    return sites;
+}
+
+Result makeResult(const Options& options, const std::string& engine, const std::string& distribution, int sites,
+    const char* phase, const std::vector<double>& samples, size_t items)
+{
+    double median = percentile(samples, 0.5);
+    return Result{
+        .engine = engine,
+        .distribution = distribution,
+        .sites = sites,
+        .phase = phase,
+        .reps = options.reps,
+        .medianMs = median,
+        .p99Ms = percentile(samples, 0.99),
+        .items = items,
+        .itemsPerSec = median > 0 ? items / (median / 1000.0) : 0.0,
+        .peakRssKb = peakRssKb(),
+    };
+}
+
+std::vector<Result> runCase(const Options& options, VoronoiEngine engine, const std::string& distribution,
+    const std::vector<Site>& sites, CellPolygons& outCells)
+{
+    const bool fortune = engine == VoronoiEngine::Fortune;
+
+    std::vector<double> construct, run, polygons, offset, offsetBatch;
+    size_t events = 0, cells = 0;
+
+    for (int rep = 0; rep < options.warmup + options.reps; rep++) {
+        std::optional<State> state;
+        std::optional<tora::sim::delaunay::Dual> dual;
+
+        auto t = Clock::now();
+        if (fortune) {
+            state.emplace(sites);
+        }
+        else {
+            dual.emplace(sites);
+        }
+        double constructMs = msSince(t);
+
+        t = Clock::now();
+        if (fortune) {
+            state->run();
+        }
+        double runMs = msSince(t);
+
+        t = Clock::now();
+        auto cellPolygons = fortune ? state->getPolygons() : dual->getPolygons();
+        double polygonsMs = msSince(t);
+
+        t = Clock::now();
+        size_t offsetVertices = 0;
+        for (const auto& cell : cellPolygons) {
+            offsetVertices += tora::geometry::offset(cell, -1.0).vertices.size();
+        }
+        double offsetMs = msSince(t);
+
+        t = Clock::now();
+        tora::geometry::PolygonSet batch;
+        const double amount = -1.0;
+        tora::geometry::offsetBatch(cellPolygons, { &amount, 1 }, batch);
+        double offsetBatchMs = msSince(t);
+
+        if (rep >= options.warmup) {
+            construct.push_back(constructMs);
+            run.push_back(runMs);
+            polygons.push_back(polygonsMs);
+            offset.push_back(offsetMs);
+            offsetBatch.push_back(offsetBatchMs);
+        }
+        events = fortune ? state->processedEvents : 0;
+        cells = cellPolygons.size();
+        sink = offsetVertices;
+
+        if (rep + 1 == options.warmup + options.reps) {
+            outCells = fortune ? state->getCellPolygons() : dual->getCellPolygons();
+        }
+    }
+
+    auto result = [&](const char* phase, const std::vector<double>& samples, size_t items) {
+        return makeResult(options, tora::sim::engineName(engine), distribution, static_cast<int>(sites.size()), phase, samples, items);
+    };
+
+    std::vector<Result> results{ result("construct", construct, sites.size()) };
+    if (fortune) {
+        results.push_back(result("run", run, events));
+    }
+    results.push_back(result("polygons", polygons, cells));
+    results.push_back(result("offset", offset, cells));
+    results.push_back(result("offset_batch", offsetBatch, cells));
+    return results;
+}
+
+// Times the lookups TriangulationGridMap::getNeighborGrids does, over both tables.
+std::vector<Result> runLookupCase(const Options& options, int n)
+{
+    using tora::sim::GridKey;
+    constexpr int kRadius = 2;
+    const int side = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(n))));
+
+    tora::FlatHashMap<int> flat;
+    std::unordered_map<GridKey, int> unordered;
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            flat.tryEmplace(GridKey{ x, y }.packed(), y * side + x);
+            unordered.emplace(GridKey{ x, y }, y * side + x);
+        }
+    }
+
+    auto time = [&](auto&& lookup) {
+        std::vector<double> samples;
+        for (int rep = 0; rep < options.warmup + options.reps; rep++) {
+            auto t = Clock::now();
+            size_t found = 0;
+            for (int y = 0; y < side; y++) {
+                for (int x = 0; x < side; x++) {
+                    for (int ty = y - kRadius; ty <= y + kRadius; ty++) {
+                        for (int tx = x - kRadius; tx <= x + kRadius; tx++) {
+                            found += lookup(GridKey{ tx, ty });
+                        }
+                    }
+                }
+            }
+            double ms = msSince(t);
+            if (rep >= options.warmup) {
+                samples.push_back(ms);
+            }
+            sink = found;
+        }
+        return samples;
+    };
+
+    auto flatSamples = time([&](const GridKey& k) {
+        auto* value = flat.find(k.packed());
+        return value ? static_cast<size_t>(*value) : 0;
+    });
+    auto unorderedSamples = time([&](const GridKey& k) {
+        auto it = unordered.find(k);
+        return it != unordered.end() ? static_cast<size_t>(it->second) : 0;
+    });
+
+    const int chunks = side * side;
+    const size_t lookups = static_cast<size_t>(chunks) * (2 * kRadius + 1) * (2 * kRadius + 1);
+    return {
+        makeResult(options, "flat_hash", "chunks", chunks, "lookup", flatSamples, lookups),
+        makeResult(options, "unordered_map", "chunks", chunks, "lookup", unorderedSamples, lookups),
+    };
+}
+
+void printCsv(const std::vector<Result>& results)
+{
+    std::printf("engine,distribution,sites,phase,reps,median_ms,p99_ms,items,items_per_sec,peak_rss_kb\n");
+    for (const auto& r : results) {
+        std::printf("%s,%s,%d,%s,%d,%.4f,%.4f,%zu,%.1f,%ld\n",
+            r.engine.c_str(), r.distribution.c_str(), r.sites, r.phase.c_str(), r.reps, r.medianMs, r.p99Ms, r.items, r.itemsPerSec, r.peakRssKb);
+    }
+}
+
+void printJson(const Options& options, const std::vector<Result>& results)
+{
+    std::printf("{\n  \"seed\": %llu,\n  \"results\": [\n", static_cast<unsigned long long>(options.seed));
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::printf("    {\"engine\": \"%s\", \"distribution\": \"%s\", \"sites\": %d, \"phase\": \"%s\", \"reps\": %d, "
+            "\"median_ms\": %.4f, \"p99_ms\": %.4f, \"items\": %zu, \"items_per_sec\": %.1f, \"peak_rss_kb\": %ld}%s\n",
+            r.engine.c_str(), r.distribution.c_str(), r.sites, r.phase.c_str(), r.reps, r.medianMs, r.p99Ms, r.items, r.itemsPerSec, r.peakRssKb,
+            i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+std::vector<std::string> splitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--format") {
+            options.format = value;
+        }
+        else if (arg == "--sizes") {
+            options.sizes.clear();
+            for (const auto& s : splitList(value)) options.sizes.push_back(std::atoi(s.c_str()));
+        }
+        else if (arg == "--distributions") {
+            options.distributions = splitList(value);
+        }
+        else if (arg == "--engines") {
+            options.engines.clear();
+            for (const auto& name : splitList(value)) {
+                auto engine = tora::sim::parseEngine(name);
+                if (!engine) {
+                    std::fprintf(stderr, "unknown engine %s\n", name.c_str());
+                    return false;
+                }
+                options.engines.push_back(*engine);
+            }
+        }
+        else if (arg == "--reps") {
+            options.reps = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--warmup") {
+            options.warmup = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return options.format == "json" || options.format == "csv";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::sort(options.sizes.begin(), options.sizes.end());
+
+    std::vector<Result> results;
+    for (int n : options.sizes) {
+        for (const auto& distribution : options.distributions) {
+            if (distribution == "chunks") {
+                auto lookupResults = runLookupCase(options, n);
+                results.insert(results.end(), lookupResults.begin(), lookupResults.end());
+                continue;
+            }
+
+            auto sites = generateSites(distribution, n, options.seed);
+
+            std::vector<CellPolygons> engineCells(options.engines.size());
+            for (size_t e = 0; e < options.engines.size(); e++) {
+                auto caseResults = runCase(options, options.engines[e], distribution, sites, engineCells[e]);
+                results.insert(results.end(), caseResults.begin(), caseResults.end());
+            }
+
+            for (size_t e = 1; e < options.engines.size(); e++) {
+                auto diff = tora::sim::compareCells(engineCells[0], engineCells[e], kCompareTolerance);
+                if (!diff.identical()) {
+                    std::fprintf(stderr, "%s/%d: %s and %s differ: %d cells only in the first, %d only in the second, "
+                        "%d mismatched, max corner distance %g\n",
+                        distribution.c_str(), n, tora::sim::engineName(options.engines[0]), tora::sim::engineName(options.engines[e]),
+                        diff.onlyInFirst, diff.onlyInSecond, diff.mismatched, diff.maxDistance);
+                }
+            }
+        }
+    }
+
+    if (options.format == "csv") {
+        printCsv(results);
+    }
+    else {
+        printJson(options, results);
+    }
+
+    return 0;
+}
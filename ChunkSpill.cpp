@@ -0,0 +1,230 @@
+#include "ChunkSpill.h"
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace tora::sim {
+
+namespace {
+
+// below this, a file is never worth compacting
+constexpr uint64_t kMinCompactBytes = 1 << 20;
+
+constexpr size_t kHeaderBytes = 4 * sizeof(uint32_t);
+constexpr size_t kVertexBytes = 2 * sizeof(float);
+constexpr size_t kEdgeBytes = 2 * sizeof(uint16_t) + 2;
+
+std::filesystem::path temporaryPath()
+{
+    // unique per process and per spill
+    static const unsigned process = std::random_device{}();
+    static std::atomic<int> counter{ 0 };
+    auto name = "tora-chunks-" + std::to_string(process) + "-" + std::to_string(counter.fetch_add(1)) + ".bin";
+    return std::filesystem::temp_directory_path() / name;
+}
+
+template <class T>
+void put(char*& out, T value)
+{
+    std::memcpy(out, &value, sizeof(T));
+    out += sizeof(T);
+}
+
+template <class T>
+T get(const char*& in)
+{
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return value;
+}
+
+constexpr auto kMode = std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc;
+
+} // namespace
+
+ChunkSpill::ChunkSpill(std::filesystem::path path)
+    : temporary_{ path.empty() }
+{
+    path_ = temporary_ ? temporaryPath() : std::move(path);
+    file_.open(path_, kMode);
+    if (!file_) {
+        throw std::runtime_error{ "cannot open chunk spill file " + path_.string() };
+    }
+}
+
+ChunkSpill::~ChunkSpill()
+{
+    file_.close();
+    if (temporary_) {
+        std::error_code ignored;
+        std::filesystem::remove(path_, ignored);
+    }
+}
+
+bool ChunkSpill::write(const GridKey& key, std::span<const Vec2f> vertices, std::span<const EdgeKey> edges)
+{
+    buffer_.resize(kHeaderBytes + vertices.size() * kVertexBytes + edges.size() * kEdgeBytes);
+    char* out = buffer_.data();
+    put<int32_t>(out, key.gridX);
+    put<int32_t>(out, key.gridY);
+    put<uint32_t>(out, static_cast<uint32_t>(vertices.size()));
+    put<uint32_t>(out, static_cast<uint32_t>(edges.size()));
+    for (const auto& v : vertices) {
+        put<float>(out, v.x);
+        put<float>(out, v.y);
+    }
+    for (const auto& e : edges) {
+        put<uint16_t>(out, static_cast<uint16_t>(e.a.index));
+        put<uint16_t>(out, static_cast<uint16_t>(e.b.index));
+        put<int8_t>(out, static_cast<int8_t>(e.b.g.gridX - key.gridX));
+        put<int8_t>(out, static_cast<int8_t>(e.b.g.gridY - key.gridY));
+    }
+
+    file_.seekp(static_cast<std::streamoff>(end_));
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    if (!file_) {
+        // whatever part of the record made it out is past end_ and gets overwritten
+        file_.clear();
+        return false;
+    }
+
+    forget(key.packed());
+    records_.tryEmplace(key.packed(), Record{ end_, static_cast<uint32_t>(buffer_.size()) });
+    end_ += buffer_.size();
+    liveBytes_ += buffer_.size();
+    compactIfSparse();
+    return true;
+}
+
+bool ChunkSpill::read(const GridKey& key, std::vector<Vec2f>& vertices, std::vector<EdgeKey>& edges)
+{
+    const auto* record = records_.find(key.packed());
+    if (!record) {
+        return false;
+    }
+
+    if (!readRecord(*record)) {
+        return false;
+    }
+
+    const char* in = buffer_.data();
+    const int gx = get<int32_t>(in);
+    const int gy = get<int32_t>(in);
+    const uint32_t vertexCount = get<uint32_t>(in);
+    const uint32_t edgeCount = get<uint32_t>(in);
+    if (gx != key.gridX || gy != key.gridY
+        || kHeaderBytes + vertexCount * kVertexBytes + edgeCount * kEdgeBytes != record->size) {
+        return false;
+    }
+
+    vertices.clear();
+    vertices.reserve(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        float x = get<float>(in);
+        float y = get<float>(in);
+        vertices.emplace_back(x, y);
+    }
+    edges.clear();
+    edges.reserve(edgeCount);
+    for (uint32_t i = 0; i < edgeCount; i++) {
+        int a = get<uint16_t>(in);
+        int b = get<uint16_t>(in);
+        int dx = get<int8_t>(in);
+        int dy = get<int8_t>(in);
+        edges.emplace_back(VertexKey{ gx, gy, a }, VertexKey{ gx + dx, gy + dy, b });
+    }
+
+    forget(key.packed());
+    compactIfSparse();
+    return true;
+}
+
+void ChunkSpill::erase(const GridKey& key)
+{
+    forget(key.packed());
+    compactIfSparse();
+}
+
+bool ChunkSpill::readRecord(const Record& record)
+{
+    buffer_.resize(record.size);
+    file_.seekg(static_cast<std::streamoff>(record.offset));
+    file_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    if (!file_ || file_.gcount() != static_cast<std::streamsize>(record.size)) {
+        file_.clear();
+        return false;
+    }
+    return true;
+}
+
+void ChunkSpill::forget(uint64_t key)
+{
+    if (const auto* record = records_.find(key)) {
+        liveBytes_ -= record->size;
+        records_.erase(key);
+    }
+}
+
+void ChunkSpill::compactIfSparse()
+{
+    if (end_ > kMinCompactBytes && end_ > 2 * liveBytes_) {
+        compact();
+    }
+}
+
+void ChunkSpill::compact()
+{
+    // Copies the live records, then swaps the copy in. Until the swap nothing changes, so
+    // a failure anywhere before it only leaves the file as sparse as it was.
+    auto path = path_;
+    path += ".compact";
+    std::error_code ignored;
+    std::fstream compacted{ path, kMode };
+
+    auto offsets = FlatHashMap<uint64_t>{};
+    offsets.reserve(records_.size());
+    uint64_t end = 0;
+    bool ok = static_cast<bool>(compacted);
+    records_.forEach([&](uint64_t key, const Record& record) {
+        if (!ok || !readRecord(record)) {
+            ok = false;
+            return;
+        }
+        compacted.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        offsets.tryEmplace(key, end);
+        end += record.size;
+    });
+    compacted.close();
+    if (!ok || !compacted) {
+        std::filesystem::remove(path, ignored);
+        return;
+    }
+
+    file_.close();
+    std::error_code renamed;
+    std::filesystem::rename(path, path_, renamed);
+    file_.clear();
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
+    if (renamed) {
+        std::filesystem::remove(path, ignored);
+        if (file_) {
+            // still the old file, records and all
+            return;
+        }
+    }
+    if (!file_) {
+        throw std::runtime_error{ "cannot reopen chunk spill file " + path_.string() };
+    }
+
+    records_.forEach([&](uint64_t key, Record& record) {
+        record.offset = *offsets.find(key);
+    });
+    end_ = end;
+}
+
+} // namespace tora::sim
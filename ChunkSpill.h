@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "GridKey.h"
+#include "VectorMath.h"
+
+namespace tora::sim {
+
+// Evicted map chunks, kept in one binary file until they are needed again.
+//
+// Each chunk is a record appended to the file:
+//
+//     int32 gx, gy; uint32 vertexCount, edgeCount
+//     vertexCount x { float x, y }
+//     edgeCount x { uint16 a.index, b.index; int8 b.gx - gx, b.gy - gy }
+//
+// An edge always starts at the chunk it is stored with, and ends in a chunk nearby, so six
+// bytes hold it instead of the 24 of an EdgeKey. The file is scratch space for this process
+// only, in native byte order. Reading a chunk back drops its record; once dropped records
+// take up more than half the file, the live ones are copied to a fresh file.
+class ChunkSpill
+{
+public:
+    // An empty path puts the file in the temporary directory and removes it afterwards.
+    // Throws std::runtime_error if the file cannot be created.
+    explicit ChunkSpill(std::filesystem::path path = {});
+    ~ChunkSpill();
+
+    ChunkSpill(const ChunkSpill&) = delete;
+    ChunkSpill& operator=(const ChunkSpill&) = delete;
+
+    bool contains(const GridKey& key) const { return records_.contains(key.packed()); }
+
+    // number of chunks in the file
+    size_t size() const { return records_.size(); }
+
+    uint64_t fileBytes() const { return end_; }
+
+    // Stores the chunk, replacing any earlier record of it. Returns false, keeping the
+    // earlier record, if the file cannot be written.
+    bool write(const GridKey& key, std::span<const Vec2f> vertices, std::span<const EdgeKey> edges);
+
+    // Replaces vertices and edges with the chunk's and drops its record. Returns false if
+    // the chunk is not in the file, or its record cannot be read back whole; the record
+    // is kept then, and vertices and edges are left alone.
+    bool read(const GridKey& key, std::vector<Vec2f>& vertices, std::vector<EdgeKey>& edges);
+
+    // drops the chunk's record, if it has one
+    void erase(const GridKey& key);
+
+private:
+    struct Record
+    {
+        uint64_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    // reads record into buffer_
+    bool readRecord(const Record& record);
+    void forget(uint64_t key);
+    void compactIfSparse();
+    void compact();
+
+    bool temporary_;
+    std::filesystem::path path_;
+    std::fstream file_;
+
+    FlatHashMap<Record> records_;
+    uint64_t end_ = 0;       // file size
+    uint64_t liveBytes_ = 0; // bytes in records_
+    std::vector<char> buffer_;
+};
+
+} // namespace tora::sim
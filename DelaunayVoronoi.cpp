@@ -0,0 +1,188 @@
+#include "DelaunayVoronoi.h"
+#include "Trace.h"
+#include "delaunator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tora::sim::delaunay {
+
+Dual::Dual(const std::vector<Site>& sites) : sites_{ sites }
+{
+    std::vector<double> coords;
+    coords.reserve(sites.size() * 2);
+    for (const auto& site : sites) {
+        coords.push_back(site.location.x);
+        coords.push_back(site.location.y);
+    }
+
+    try {
+        delaunator::Delaunator d{ coords };
+        triangles_ = std::move(d.triangles);
+        halfEdges_ = std::move(d.halfedges);
+    }
+    catch (const std::runtime_error&) {
+        // fewer than three sites, or all of them on a line
+        TORA_TRACE(Debug, "no triangulation for %zu sites, treating them as collinear", sites.size());
+        return;
+    }
+
+    circumcenters_.resize(triangles_.size() / 3);
+    for (size_t t = 0; t < circumcenters_.size(); t++) {
+        const auto& a = sites_[triangles_[3 * t]].location;
+        const auto& b = sites_[triangles_[3 * t + 1]].location;
+        const auto& c = sites_[triangles_[3 * t + 2]].location;
+        auto [x, y] = delaunator::circumcenter(a.x, a.y, b.x, b.y, c.x, c.y);
+        circumcenters_[t] = Point(x, y);
+    }
+
+    incoming_.assign(sites_.size(), kInvalid);
+    for (size_t e = 0; e < triangles_.size(); e++) {
+        size_t p = triangles_[nextHalfEdge(e)];
+        if (incoming_[p] == kInvalid || halfEdges_[e] == kInvalid) {
+            incoming_[p] = e;
+        }
+    }
+}
+
+CellPolygons Dual::getCellPolygons(const std::optional<Polygon>& bounds) const
+{
+    // clipping expects positive winding
+    auto boundary = bounds;
+    if (boundary && geometry::windingDirection(*boundary) < 0) {
+        std::reverse(boundary->vertices.begin(), boundary->vertices.end());
+    }
+
+    CellPolygons result;
+    result.offsets.push_back(0);
+
+    if (triangles_.empty()) {
+        if (boundary) {
+            appendCollinearCells(*boundary, result);
+        }
+        return result;
+    }
+
+    // first pass: find closed cells and lay out the offsets
+    const int n = static_cast<int>(sites_.size());
+    std::vector<int> clipped;
+    for (int p = 0; p < n; p++) {
+        size_t start = incoming_[p];
+        if (start == kInvalid) {
+            continue;
+        }
+
+        int degree = 0;
+        bool inside = true;
+        size_t e = start;
+        do {
+            degree++;
+            inside = inside && (!boundary || geometry::convexContains(*boundary, circumcenters_[e / 3]));
+            e = halfEdges_[nextHalfEdge(e)];
+        } while (e != kInvalid && e != start);
+
+        if (e == start && degree > 2 && inside) {
+            result.sites.push_back(p);
+            result.offsets.push_back(result.offsets.back() + degree);
+        }
+        else if (boundary) {
+            clipped.push_back(p);
+        }
+    }
+    const int numClosed = result.size();
+
+    // Bounded mode: the other cells are the boundary cut down by the bisector towards
+    // each Delaunay neighbor. The walk from a hull edge misses the neighbor across the
+    // last outgoing edge, which is a hull edge too.
+    std::vector<std::vector<Point>> clippedVertices;
+    if (boundary) {
+        std::vector<Point> scratch;
+        for (int p : clipped) {
+            auto vertices = boundary->vertices;
+            const auto& site = sites_[p].location;
+
+            size_t start = incoming_[p];
+            size_t e = start;
+            while (true) {
+                geometry::clipToBisector(vertices, site, sites_[triangles_[e]].location, scratch);
+                size_t outgoing = nextHalfEdge(e);
+                e = halfEdges_[outgoing];
+                if (e == kInvalid) {
+                    geometry::clipToBisector(vertices, site, sites_[triangles_[nextHalfEdge(outgoing)]].location, scratch);
+                    break;
+                }
+                if (e == start) {
+                    break;
+                }
+            }
+
+            // empty for sites outside the boundary
+            if (vertices.size() > 2) {
+                result.sites.push_back(p);
+                result.offsets.push_back(result.offsets.back() + static_cast<int>(vertices.size()));
+                clippedVertices.push_back(std::move(vertices));
+            }
+        }
+    }
+
+    // second pass: fill the vertices
+    result.vertices.resize(result.offsets.back());
+    for (int i = 0; i < numClosed; i++) {
+        int k = result.offsets[i];
+        size_t start = incoming_[result.sites[i]];
+        size_t e = start;
+        do {
+            result.vertices[k++] = circumcenters_[e / 3];
+            e = halfEdges_[nextHalfEdge(e)];
+        } while (e != start);
+    }
+    for (int i = numClosed; i < result.size(); i++) {
+        const auto& vertices = clippedVertices[i - numClosed];
+        std::copy(vertices.begin(), vertices.end(), result.vertices.begin() + result.offsets[i]);
+    }
+
+    for (auto& site : result.sites) {
+        site = sites_[site].id;
+    }
+
+    return result;
+}
+
+PolygonSet Dual::getPolygons(const std::optional<Polygon>& bounds) const
+{
+    return fortune::toPolygons(getCellPolygons(bounds));
+}
+
+void Dual::appendCollinearCells(const Polygon& boundary, CellPolygons& result) const
+{
+    // sites on a line sorted along it, each cell is the slab between its two neighbors
+    std::vector<int> order(sites_.size());
+    for (int i = 0; i < static_cast<int>(order.size()); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const auto& pa = sites_[a].location;
+        const auto& pb = sites_[b].location;
+        return pa.x < pb.x || (pa.x == pb.x && pa.y < pb.y);
+    });
+
+    std::vector<Point> scratch;
+    for (size_t i = 0; i < order.size(); i++) {
+        const auto& site = sites_[order[i]].location;
+        auto vertices = boundary.vertices;
+        if (i > 0) {
+            geometry::clipToBisector(vertices, site, sites_[order[i - 1]].location, scratch);
+        }
+        if (i + 1 < order.size()) {
+            geometry::clipToBisector(vertices, site, sites_[order[i + 1]].location, scratch);
+        }
+
+        if (vertices.size() > 2) {
+            result.sites.push_back(sites_[order[i]].id);
+            result.vertices.insert(result.vertices.end(), vertices.begin(), vertices.end());
+            result.offsets.push_back(static_cast<int>(result.vertices.size()));
+        }
+    }
+}
+
+} // namespace tora::sim::delaunay
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "Geometry.h"
+#include "Sweeping.h"
+
+namespace tora::sim::delaunay {
+
+using namespace tora::geometry;
+using fortune::Site;
+using fortune::CellPolygons;
+
+// Voronoi cells read off the dual of delaunator's Delaunay triangulation.
+// The corners of a site's cell are the circumcenters of the triangles around it, so a
+// cell is one walk around the site over the triangulation's half-edges. Circumcenters
+// are computed once per triangle into a flat array shared by all cells.
+// Produces the same output as fortune::State, site for site.
+class Dual
+{
+public:
+    explicit Dual(const std::vector<Site>& sites);
+
+    // See fortune::State::getCellPolygons. Without bounds, hull cells are left out;
+    // with one, every cell is clipped to it and every site inside it gets a cell.
+    CellPolygons getCellPolygons(const std::optional<Polygon>& bounds = std::nullopt) const;
+    PolygonSet getPolygons(const std::optional<Polygon>& bounds = std::nullopt) const;
+
+    // one per triangle, indexed by half-edge / 3
+    const std::vector<Point>& circumcenters() const { return circumcenters_; }
+
+private:
+    static constexpr size_t kInvalid = static_cast<size_t>(-1);
+
+    static size_t nextHalfEdge(size_t e) { return e % 3 == 2 ? e - 2 : e + 1; }
+
+    void appendCollinearCells(const Polygon& boundary, CellPolygons& result) const;
+
+    std::vector<Site> sites_;
+
+    // delaunator output, see delaunator.hpp. Empty when all sites are collinear.
+    std::vector<size_t> triangles_;
+    std::vector<size_t> halfEdges_;
+
+    std::vector<Point> circumcenters_;
+
+    // per site, a half-edge pointing at it, a hull edge if there is one so that walks
+    // around hull sites cover all of their triangles. kInvalid for duplicate sites.
+    std::vector<size_t> incoming_;
+};
+
+} // namespace tora::sim::delaunay
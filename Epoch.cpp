@@ -0,0 +1,127 @@
+#include "Epoch.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace tora {
+
+// the calling thread's slot in the shared domain, given back when the thread exits
+struct EpochThreadState
+{
+    int slot = -1;
+    int depth = 0;
+
+    ~EpochThreadState()
+    {
+        if (slot >= 0) {
+            EpochDomain::shared().releaseSlot(slot);
+        }
+    }
+};
+
+namespace {
+
+thread_local EpochThreadState threadState;
+
+} // namespace
+
+EpochDomain& EpochDomain::shared()
+{
+    // never destroyed: pool threads may still release their slots during static destruction
+    static EpochDomain* domain = new EpochDomain;
+    return *domain;
+}
+
+EpochDomain::Guard EpochDomain::pin()
+{
+    auto& state = threadState;
+    if (state.depth++ > 0) {
+        return Guard{ this };
+    }
+    if (state.slot < 0) {
+        state.slot = acquireSlot();
+    }
+    // seq_cst: the store is ordered before the reader's loads of the shared data, so a
+    // writer that sees the slot empty has swapped its pointer before those loads
+    slots_[state.slot].epoch.store(global_.load());
+    return Guard{ this };
+}
+
+void EpochDomain::unpin()
+{
+    auto& state = threadState;
+    if (--state.depth == 0) {
+        slots_[state.slot].epoch.store(0);
+    }
+}
+
+int EpochDomain::acquireSlot()
+{
+    while (true) {
+        for (int i = 0; i < kMaxThreads; i++) {
+            bool expected = false;
+            if (!slots_[i].taken.load(std::memory_order_relaxed)
+                && slots_[i].taken.compare_exchange_strong(expected, true)) {
+                return i;
+            }
+        }
+        // more pinning threads than slots; wait for one to exit
+        std::this_thread::yield();
+    }
+}
+
+void EpochDomain::releaseSlot(int slot)
+{
+    slots_[slot].epoch.store(0);
+    slots_[slot].taken.store(false);
+}
+
+void EpochDomain::retire(std::function<void()> reclaim)
+{
+    {
+        std::lock_guard lock{ retiredMutex_ };
+        // readers pinned from now on see an epoch above this one
+        retired_.push_back(Retired{ global_.fetch_add(1), std::move(reclaim) });
+    }
+    collect();
+}
+
+void EpochDomain::synchronize()
+{
+    if (threadState.depth > 0) {
+        throw std::logic_error{ "EpochDomain::synchronize called while pinned" };
+    }
+    while (collect() > 0) {
+        std::this_thread::yield();
+    }
+}
+
+size_t EpochDomain::collect()
+{
+    std::vector<Retired> ready;
+    size_t waiting;
+    {
+        std::lock_guard lock{ retiredMutex_ };
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        for (const auto& slot : slots_) {
+            uint64_t e = slot.epoch.load();
+            if (e != 0) {
+                oldest = std::min(oldest, e);
+            }
+        }
+        // a reader pinned at epoch e may hold anything retired at e or later
+        auto stillVisible = std::stable_partition(retired_.begin(), retired_.end(),
+            [oldest](const Retired& r) { return r.epoch >= oldest; });
+        ready.assign(std::make_move_iterator(stillVisible), std::make_move_iterator(retired_.end()));
+        retired_.erase(stillVisible, retired_.end());
+        waiting = retired_.size();
+    }
+    for (auto& r : ready) {
+        r.reclaim();
+    }
+    return waiting;
+}
+
+} // namespace tora
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace tora {
+
+// Epoch-based reclamation, for data read without locks and replaced by writers (RCU).
+//
+// A reader pins the domain for as long as it uses the shared data:
+//
+//     auto guard = EpochDomain::shared().pin();
+//     const Snapshot* s = current.load(); // valid until guard goes away
+//
+// A writer swaps in the replacement first and then retires the old version. Retired
+// objects are reclaimed once every reader that was pinned at the time of retirement has
+// unpinned, so readers never wait and never touch reference counts.
+//
+// Each thread that pins takes one of kMaxThreads slots until it exits. Pins nest.
+class EpochDomain
+{
+public:
+    static constexpr int kMaxThreads = 256;
+
+    class Guard
+    {
+    public:
+        Guard() = default;
+        Guard(Guard&& other) noexcept : domain_{ std::exchange(other.domain_, nullptr) } {}
+        Guard& operator=(Guard&& other) noexcept
+        {
+            std::swap(domain_, other.domain_);
+            return *this;
+        }
+        ~Guard()
+        {
+            if (domain_) domain_->unpin();
+        }
+
+    private:
+        friend class EpochDomain;
+        explicit Guard(EpochDomain* domain) : domain_{ domain } {}
+
+        EpochDomain* domain_ = nullptr;
+    };
+
+    static EpochDomain& shared();
+
+    Guard pin();
+
+    // Calls reclaim once no reader pinned before this call is still pinned; maybe right
+    // away, maybe from a later retire() on any thread.
+    void retire(std::function<void()> reclaim);
+
+    // Blocks until every reader pinned now has unpinned, then reclaims everything retired
+    // so far. Throws std::logic_error if the calling thread is pinned, as it would wait
+    // for itself forever.
+    void synchronize();
+
+private:
+    EpochDomain() = default;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch{ 0 }; // 0 while the owner is not pinned
+        std::atomic<bool> taken{ false };
+    };
+
+    struct Retired
+    {
+        uint64_t epoch;
+        std::function<void()> reclaim;
+    };
+
+    void unpin();
+    int acquireSlot();
+    void releaseSlot(int slot);
+
+    // reclaims what no pinned reader can see, returns the number of objects still waiting
+    size_t collect();
+
+    std::atomic<uint64_t> global_{ 1 };
+    Slot slots_[kMaxThreads];
+
+    std::mutex retiredMutex_;
+    std::vector<Retired> retired_;
+
+    friend struct EpochThreadState;
+};
+
+} // namespace tora
@@ -0,0 +1,169 @@
+#include "EventQueue.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace tora::sim::fortune {
+
+namespace {
+
+constexpr size_t kMinParallelSortChunk = 1 << 16;
+
+// Sorts chunks on separate threads, then merges them pairwise, one level at a time.
+template <class It, class Less>
+void parallelSort(It first, It last, Less less)
+{
+    const size_t n = last - first;
+    const size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), n / kMinParallelSortChunk);
+    if (threads < 2) {
+        std::sort(first, last, less);
+        return;
+    }
+
+    std::vector<It> bounds;
+    for (size_t i = 0; i <= threads; i++) {
+        bounds.push_back(first + n * i / threads);
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([&, i] { std::sort(bounds[i], bounds[i + 1], less); });
+    }
+    for (auto& w : workers) w.join();
+
+    for (size_t width = 1; width < threads; width *= 2) {
+        workers.clear();
+        for (size_t i = 0; i + width < threads; i += 2 * width) {
+            auto mid = bounds[i + width];
+            auto end = bounds[std::min(i + 2 * width, threads)];
+            workers.emplace_back([&, i, mid, end] { std::inplace_merge(bounds[i], mid, end, less); });
+        }
+        for (auto& w : workers) w.join();
+    }
+}
+
+} // namespace
+
+EventQueue::EventQueue(const std::vector<Site>& sites)
+{
+    sites_.reserve(sites.size());
+    for (const auto& site : sites) {
+        sites_.push_back(SiteKey{ .y = site.location.y, .x = site.location.x, .site = site.id });
+    }
+
+    auto less = [](const SiteKey& a, const SiteKey& b) {
+        return a.y < b.y || (a.y == b.y && (a.x < b.x || (a.x == b.x && a.site < b.site)));
+    };
+    if (!std::is_sorted(sites_.begin(), sites_.end(), less)) {
+        parallelSort(sites_.begin(), sites_.end(), less);
+    }
+}
+
+void EventQueue::pushVertex(ArcRef arc, double y)
+{
+    arc->event = nextEventId_++;
+    heap_.push_back(Event::Vertex(arc, y, arc->event));
+    siftUp(heap_.size() - 1);
+}
+
+void EventQueue::cancel(ArcRef arc)
+{
+    if (arc->event < 0) {
+        return;
+    }
+
+    arc->event = -1;
+    cancelled_++;
+
+    if (heap_.size() >= kMinCompactSize && cancelled_ * 2 > heap_.size()) {
+        compact();
+    }
+}
+
+bool EventQueue::pop(Event& out)
+{
+    while (!heap_.empty() && !isLive(heap_.front())) {
+        popHeap();
+        cancelled_--;
+    }
+
+    bool hasSite = nextSite_ < sites_.size();
+    if (heap_.empty() && !hasSite) {
+        return false;
+    }
+
+    if (!heap_.empty() && (!hasSite || heap_.front().y <= sites_[nextSite_].y)) {
+        out = heap_.front();
+        out.arc->event = -1;
+        popHeap();
+    }
+    else {
+        const auto& key = sites_[nextSite_++];
+        out = Event::Site(key.site, key.y);
+    }
+
+    return true;
+}
+
+void EventQueue::siftUp(size_t i)
+{
+    Event ev = heap_[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / kArity;
+        if (heap_[parent].y <= ev.y) {
+            break;
+        }
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = ev;
+}
+
+void EventQueue::siftDown(size_t i)
+{
+    const size_t n = heap_.size();
+    Event ev = heap_[i];
+    while (true) {
+        size_t first = i * kArity + 1;
+        if (first >= n) {
+            break;
+        }
+        size_t best = first;
+        size_t last = std::min(first + kArity, n);
+        for (size_t c = first + 1; c < last; c++) {
+            if (heap_[c].y < heap_[best].y) {
+                best = c;
+            }
+        }
+        if (ev.y <= heap_[best].y) {
+            break;
+        }
+        heap_[i] = heap_[best];
+        i = best;
+    }
+    heap_[i] = ev;
+}
+
+void EventQueue::popHeap()
+{
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+        siftDown(0);
+    }
+}
+
+void EventQueue::compact()
+{
+    heap_.erase(std::remove_if(heap_.begin(), heap_.end(), [](const Event& ev) { return !isLive(ev); }), heap_.end());
+    cancelled_ = 0;
+
+    // Floyd's heap construction
+    for (size_t i = heap_.size() / kArity + 1; i-- > 0;) {
+        if (i < heap_.size()) {
+            siftDown(i);
+        }
+    }
+}
+
+} // namespace tora::sim::fortune
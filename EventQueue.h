@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Geometry.h"
+#include "Beachline.h"
+
+namespace tora::sim::fortune {
+
+using namespace tora::geometry;
+
+struct Site
+{
+    int id;
+    Point location;
+};
+
+struct Event {
+    int type;
+    double y;
+    int site;
+    ArcRef arc = nullptr; // vertex events only: the arc that disappears
+    int id = -1;          // vertex events only: equals arc->event while the event is pending
+    static constexpr int SITE = 0;
+    static constexpr int VERTEX = 1;
+
+    static Event Vertex(ArcRef arc, double y, int id) {
+        return Event{ .type = VERTEX, .y = y, .site = arc->site, .arc = arc, .id = id };
+    }
+
+    static Event Site(int site, double y) {
+        return Event{ .type = SITE, .y = y, .site = site };
+    }
+};
+
+// Event queue of the sweep, merged from two sources:
+// - site events, read with a cursor from an array of sites sorted by y
+// - vertex events, kept in a 4-ary min-heap keyed by their exact y
+// Cancelling a vertex event only clears arc->event, the heap entry is dropped when it
+// surfaces or when dead entries make up half of the heap and it gets compacted.
+class EventQueue
+{
+public:
+    EventQueue() = default;
+    explicit EventQueue(const std::vector<Site>& sites);
+
+    void pushVertex(ArcRef arc, double y);
+    void cancel(ArcRef arc);
+
+    // Takes the next live event in sweep order, vertex events first on ties.
+    // Returns false when both sources are exhausted.
+    bool pop(Event& out);
+
+    // heap storage, may contain cancelled events (see isLive)
+    const std::vector<Event>& vertexEvents() const { return heap_; }
+    static bool isLive(const Event& ev) { return ev.arc->event == ev.id; }
+
+private:
+    struct SiteKey
+    {
+        double y;
+        double x;
+        int site;
+    };
+
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void popHeap();
+    void compact();
+
+    static constexpr size_t kArity = 4;
+    static constexpr size_t kMinCompactSize = 64;
+
+    std::vector<SiteKey> sites_;
+    size_t nextSite_ = 0;
+
+    std::vector<Event> heap_;
+    size_t cancelled_ = 0;
+    int nextEventId_ = 0;
+};
+
+} // namespace tora::sim::fortune
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace tora {
+
+// splitmix64 finalizer: every input bit affects every output bit
+inline uint64_t mix64(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Open-addressing hash map from 64-bit keys to values.
+//
+// Keys, values and occupancy live in flat arrays sized to a power of two, probed linearly
+// from mix64(key), so a lookup is a hash and a short scan of adjacent slots rather than a
+// walk down a bucket list. The table doubles past 7/8 full. Erase shifts the following
+// entries back instead of leaving tombstones.
+//
+// Pointers to values stay valid until the next insertion that grows the table, or the
+// next erase.
+template <class Value>
+class FlatHashMap
+{
+public:
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Value* find(uint64_t key)
+    {
+        return const_cast<Value*>(std::as_const(*this).find(key));
+    }
+
+    const Value* find(uint64_t key) const
+    {
+        if (size_ == 0) {
+            return nullptr;
+        }
+        for (size_t i = slotOf(key);; i = (i + 1) & mask_) {
+            if (!used_[i]) {
+                return nullptr;
+            }
+            if (keys_[i] == key) {
+                return &values_[i];
+            }
+        }
+    }
+
+    bool contains(uint64_t key) const { return find(key) != nullptr; }
+
+    // Inserts value under key unless the key is present. Returns the stored value and
+    // whether it was inserted.
+    std::pair<Value*, bool> tryEmplace(uint64_t key, Value value)
+    {
+        if ((size_ + 1) * 8 > keys_.size() * 7) {
+            rehash(keys_.empty() ? kMinCapacity : keys_.size() * 2);
+        }
+        size_t i = slotOf(key);
+        for (; used_[i]; i = (i + 1) & mask_) {
+            if (keys_[i] == key) {
+                return { &values_[i], false };
+            }
+        }
+        used_[i] = 1;
+        keys_[i] = key;
+        values_[i] = std::move(value);
+        size_++;
+        return { &values_[i], true };
+    }
+
+    Value& operator[](uint64_t key)
+    {
+        return *tryEmplace(key, Value{}).first;
+    }
+
+    bool erase(uint64_t key)
+    {
+        if (size_ == 0) {
+            return false;
+        }
+        size_t i = slotOf(key);
+        for (; used_[i]; i = (i + 1) & mask_) {
+            if (keys_[i] == key) {
+                break;
+            }
+        }
+        if (!used_[i]) {
+            return false;
+        }
+
+        // pull back every later entry of the run that may sit in the gap
+        for (size_t j = (i + 1) & mask_; used_[j]; j = (j + 1) & mask_) {
+            size_t home = slotOf(keys_[j]);
+            if (((j - home) & mask_) >= ((j - i) & mask_)) {
+                keys_[i] = keys_[j];
+                values_[i] = std::move(values_[j]);
+                i = j;
+            }
+        }
+        used_[i] = 0;
+        values_[i] = Value{};
+        size_--;
+        return true;
+    }
+
+    void clear()
+    {
+        keys_.clear();
+        values_.clear();
+        used_.clear();
+        mask_ = 0;
+        size_ = 0;
+    }
+
+    void reserve(size_t count)
+    {
+        size_t capacity = std::bit_ceil(std::max<size_t>(kMinCapacity, (count * 8 + 6) / 7));
+        if (capacity > keys_.size()) {
+            rehash(capacity);
+        }
+    }
+
+    // f(key, value) for every entry, in table order
+    template <class F>
+    void forEach(F&& f)
+    {
+        for (size_t i = 0; i < keys_.size(); i++) {
+            if (used_[i]) {
+                f(keys_[i], values_[i]);
+            }
+        }
+    }
+
+    template <class F>
+    void forEach(F&& f) const
+    {
+        for (size_t i = 0; i < keys_.size(); i++) {
+            if (used_[i]) {
+                f(keys_[i], values_[i]);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kMinCapacity = 16;
+
+    size_t slotOf(uint64_t key) const { return static_cast<size_t>(mix64(key)) & mask_; }
+
+    void rehash(size_t capacity)
+    {
+        auto keys = std::move(keys_);
+        auto values = std::move(values_);
+        auto used = std::move(used_);
+
+        keys_.assign(capacity, 0);
+        values_.clear();
+        values_.resize(capacity);
+        used_.assign(capacity, 0);
+        mask_ = capacity - 1;
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (used[i]) {
+                size_t j = slotOf(keys[i]);
+                while (used_[j]) {
+                    j = (j + 1) & mask_;
+                }
+                used_[j] = 1;
+                keys_[j] = keys[i];
+                values_[j] = std::move(values[i]);
+            }
+        }
+    }
+
+    std::vector<uint64_t> keys_;
+    std::vector<Value> values_;
+    std::vector<uint8_t> used_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace tora
@@ -1,6 +1,8 @@
 #include "Geometry.h"
+#include "Predicates.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <list>
 #include <unordered_map>
@@ -30,9 +32,150 @@ bool Polygon::contains(const Point& p) const
 int windingDirection(const Polygon& polygon);
 bool intersect(const Segment& s1, const Segment& s2, Point& outIntersection);
 
-Polygon tora::geometry::offset(const Polygon& polygon, double amount)
+namespace {
+
+struct PathIntersection
 {
-    std::list<NamedVertex> vertices;
+    int i;
+    int j;
+    Point p;
+};
+
+// below this many segments a grid costs more than testing every pair
+constexpr int kMinGridSegments = 64;
+
+// Finds where the segments of a closed path cross. Segment k runs from path[k] to
+// path[k + 1], wrapping around. Every pair of non-adjacent segments is tested once, and
+// the result comes out sorted by (i, j) with i < j.
+// Long paths go through a uniform grid broad phase: each segment is binned into the
+// cells its bounding box covers, and a pair is only tested in the first cell both cover,
+// so no pair is tested twice and no set of tested pairs is needed.
+void findPathIntersections(const std::vector<Point>& path, std::vector<PathIntersection>& out)
+{
+    out.clear();
+    const int m = static_cast<int>(path.size());
+
+    auto adjacent = [m](int i, int j) { return j == i + 1 || (i == 0 && j == m - 1); };
+    auto test = [&](int i, int j) {
+        Point intersection;
+        if (intersect(Segment{ path[i], path[(i + 1) % m] }, Segment{ path[j], path[(j + 1) % m] }, intersection)) {
+            out.push_back(PathIntersection{ .i = i, .j = j, .p = intersection });
+        }
+    };
+
+    if (m < kMinGridSegments) {
+        for (int i = 0; i < m; i++) {
+            for (int j = i + 2; j < m; j++) {
+                if (!adjacent(i, j)) {
+                    test(i, j);
+                }
+            }
+        }
+        return;
+    }
+
+    struct Box
+    {
+        Point min;
+        Point max;
+    };
+
+    std::vector<Box> boxes(m);
+    Box bounds{ path[0], path[0] };
+    double totalLength = 0;
+    for (int k = 0; k < m; k++) {
+        const auto& a = path[k];
+        const auto& b = path[(k + 1) % m];
+        boxes[k] = Box{ Point(std::min(a.x, b.x), std::min(a.y, b.y)), Point(std::max(a.x, b.x), std::max(a.y, b.y)) };
+        bounds.min = Point(std::min(bounds.min.x, a.x), std::min(bounds.min.y, a.y));
+        bounds.max = Point(std::max(bounds.max.x, a.x), std::max(bounds.max.y, a.y));
+        totalLength += std::sqrt(distSqr(a, b));
+    }
+
+    // about one cell per segment, but no smaller than a typical segment
+    double width = bounds.max.x - bounds.min.x;
+    double height = bounds.max.y - bounds.min.y;
+    double cellSize = std::max(std::sqrt(width * height / m), totalLength / m);
+    if (!(cellSize > 0)) {
+        cellSize = 1;
+    }
+    const int cols = std::min(m, static_cast<int>(width / cellSize) + 1);
+    const int rows = std::min(m, static_cast<int>(height / cellSize) + 1);
+
+    auto col = [&](double x) { return std::clamp(static_cast<int>((x - bounds.min.x) / cellSize), 0, cols - 1); };
+    auto row = [&](double y) { return std::clamp(static_cast<int>((y - bounds.min.y) / cellSize), 0, rows - 1); };
+
+    // bin segments into cells, CSR layout
+    std::vector<int> cellStart(cols * rows + 1, 0);
+    for (const auto& box : boxes) {
+        for (int r = row(box.min.y); r <= row(box.max.y); r++) {
+            for (int c = col(box.min.x); c <= col(box.max.x); c++) {
+                cellStart[r * cols + c + 1]++;
+            }
+        }
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    std::vector<int> cellSegments(cellStart.back());
+    {
+        auto fill = cellStart;
+        for (int k = 0; k < m; k++) {
+            const auto& box = boxes[k];
+            for (int r = row(box.min.y); r <= row(box.max.y); r++) {
+                for (int c = col(box.min.x); c <= col(box.max.x); c++) {
+                    cellSegments[fill[r * cols + c]++] = k;
+                }
+            }
+        }
+    }
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int begin = cellStart[r * cols + c];
+            int end = cellStart[r * cols + c + 1];
+            for (int a = begin; a < end; a++) {
+                for (int b = a + 1; b < end; b++) {
+                    int i = std::min(cellSegments[a], cellSegments[b]);
+                    int j = std::max(cellSegments[a], cellSegments[b]);
+                    if (adjacent(i, j)) {
+                        continue;
+                    }
+
+                    const auto& bi = boxes[i];
+                    const auto& bj = boxes[j];
+                    if (bi.max.x < bj.min.x || bj.max.x < bi.min.x || bi.max.y < bj.min.y || bj.max.y < bi.min.y) {
+                        continue;
+                    }
+                    // test the pair only in the first cell both boxes cover
+                    if (col(std::max(bi.min.x, bj.min.x)) != c || row(std::max(bi.min.y, bj.min.y)) != r) {
+                        continue;
+                    }
+
+                    test(i, j);
+                }
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+        return a.i < b.i || (a.i == b.i && a.j < b.j);
+    });
+}
+
+} // namespace
+
+Polygon offset(const Polygon& polygon, double amount)
+{
+    if (isConvex(polygon)) {
+        Polygon result;
+        offsetConvex(polygon, amount, result);
+        return result;
+    }
+
+    // offset path: each edge moved outwards, consecutive edges joined by a connecting segment
+    std::vector<Point> path;
+    path.reserve(polygon.vertices.size() * 2);
 
     for (int i = 0; i < polygon.vertices.size(); i++) {
         auto& vertex = polygon.vertices[i];
@@ -55,59 +198,38 @@ Polygon tora::geometry::offset(const Polygon& polygon, double amount)
         vector.y *= amount;
 
         // Push new vertices
-        vertices.push_back({ .name = static_cast<int>(vertices.size()), .p = vertex + vector });
-        vertices.push_back({ .name = static_cast<int>(vertices.size()), .p = nextVertex + vector });
+        path.push_back(vertex + vector);
+        path.push_back(nextVertex + vector);
+    }
+
+    std::list<NamedVertex> vertices;
+    const int pathSize = static_cast<int>(path.size());
+    for (int i = 0; i < pathSize; i++) {
+        vertices.push_back({ .name = i, .p = path[i] });
     }
 
     // create intersection points
     {
         int vid = static_cast<int>(vertices.size());
-        // std::cout << "vid: " << vid << "\n";
 
-        // key: starting vertex of a segment
+        // index: starting vertex of a segment
         // value: list of intersection points
-        std::unordered_map<int, std::vector<NamedVertex>> segmentIntersections;
-
-        // find intersections
-        auto v1 = vertices.begin();
-        while (v1 != vertices.end()) {
-            auto v2 = std::next(v1);
-            if (v2 == vertices.end())
-                v2 = vertices.begin();
-
-            Segment s1{ .v1 = v1->p, .v2 = v2->p };
-
-            auto v3 = std::next(v2);
-
-            while (v3 != vertices.end()) {
-                auto v4 = std::next(v3);
-
-                if (v4 == vertices.end())
-                    v4 = vertices.begin();
-                
-                if (v4 == v1) break;
-
-                Segment s2{ .v1 = v3->p, .v2 = v4->p };
-
-                Point intersection;
-                if (intersect(s1, s2, intersection)) {
-                    auto nv = NamedVertex{ .name = vid++, .p = intersection };
-                    segmentIntersections[v1->name].push_back(nv);
-                    segmentIntersections[v3->name].push_back(nv);
-                }
-
-                v3++;
-            }
-            v1++;
+        std::vector<std::vector<NamedVertex>> segmentIntersections(path.size());
+
+        std::vector<PathIntersection> crossings;
+        findPathIntersections(path, crossings);
+        for (const auto& x : crossings) {
+            auto nv = NamedVertex{ .name = vid++, .p = x.p };
+            segmentIntersections[x.i].push_back(nv);
+            segmentIntersections[x.j].push_back(nv);
         }
 
         // add intersections along the path
         auto v = vertices.begin();
         while (v != vertices.end()) {
             auto next = std::next(v);
-            auto it = segmentIntersections.find(v->name);
-            if (it != segmentIntersections.end()) {
-                auto& intersections = it->second;
+            if (!segmentIntersections[v->name].empty()) {
+                auto& intersections = segmentIntersections[v->name];
                 auto& np = next == vertices.end() ? vertices.begin()->p : next->p;
                 std::sort(intersections.begin(), intersections.end(), [&](const auto& a, const auto& b) {
                     return dot(a.p - v->p, np - v->p) < dot(b.p - v->p, np - v->p);
@@ -184,6 +306,201 @@ Polygon tora::geometry::offset(const Polygon& polygon, double amount)
     return result;
 }
 
+namespace {
+
+// same arithmetic as offset(), so inflated vertices match it exactly
+Point edgeShift(const Point& vertex, const Point& nextVertex, double amount)
+{
+    auto vector = Point{ nextVertex.y - vertex.y, vertex.x - nextVertex.x };
+    auto length = sqrt(vector.x * vector.x + vector.y * vector.y);
+    vector.x /= length;
+    vector.y /= length;
+    vector.x *= amount;
+    vector.y *= amount;
+    return vector;
+}
+
+struct Line
+{
+    Point p;
+    Point d;
+};
+
+Point lineIntersection(const Line& a, const Line& b)
+{
+    return a.p + a.d * (cross(b.p - a.p, b.d) / cross(a.d, b.d));
+}
+
+} // namespace
+
+void offsetConvex(const Polygon& polygon, double amount, Polygon& out)
+{
+    const auto& v = polygon.vertices;
+    const int n = static_cast<int>(v.size());
+    const int winding = windingDirection(polygon);
+    out.vertices.clear();
+
+    if (amount * winding >= 0) {
+        // inflating: the shifted edges never cross, consecutive ones are bridged
+        for (int i = 0; i < n; i++) {
+            const auto& a = v[i];
+            const auto& b = v[(i + 1) % n];
+            if (a.x == b.x && a.y == b.y) {
+                continue;
+            }
+            auto shift = edgeShift(a, b, amount);
+            out.vertices.push_back(a + shift);
+            out.vertices.push_back(b + shift);
+        }
+        return;
+    }
+
+    // Shrinking: intersect the half-planes left of each shifted edge, taken in positive
+    // winding. A convex polygon lists its edges sorted by angle already, so the usual
+    // deque sweep runs without sorting.
+    thread_local std::vector<Line> lines;
+    thread_local std::vector<int> deque;
+    lines.clear();
+
+    const double distance = std::abs(amount);
+    for (int k = 0; k < n; k++) {
+        int i = winding > 0 ? k : n - 1 - k;
+        int j = winding > 0 ? (k + 1) % n : (2 * n - 2 - k) % n;
+        auto d = v[j] - v[i];
+        if (d.x == 0 && d.y == 0) {
+            continue;
+        }
+        // a collinear edge shifts onto the same line as the one before it
+        if (!lines.empty() && cross(lines.back().d, d) == 0 && dot(lines.back().d, d) > 0) {
+            continue;
+        }
+        double length = std::sqrt(dot(d, d));
+        lines.push_back(Line{ .p = v[i] + Point(-d.y, d.x) * (distance / length), .d = d });
+    }
+    if (lines.size() > 1 && cross(lines.back().d, lines.front().d) == 0 && dot(lines.back().d, lines.front().d) > 0) {
+        lines.pop_back();
+    }
+
+    auto outside = [](const Line& line, const Point& p) { return cross(line.d, p - line.p) < 0; };
+
+    deque.resize(lines.size());
+    int head = 0, tail = 0; // deque is [head, tail)
+    for (int i = 0; i < static_cast<int>(lines.size()); i++) {
+        const auto& line = lines[i];
+        while (tail - head >= 2 && outside(line, lineIntersection(lines[deque[tail - 2]], lines[deque[tail - 1]]))) {
+            tail--;
+        }
+        while (tail - head >= 2 && outside(line, lineIntersection(lines[deque[head]], lines[deque[head + 1]]))) {
+            head++;
+        }
+        deque[tail++] = i;
+    }
+    while (tail - head >= 3 && outside(lines[deque[head]], lineIntersection(lines[deque[tail - 2]], lines[deque[tail - 1]]))) {
+        tail--;
+    }
+    while (tail - head >= 3 && outside(lines[deque[tail - 1]], lineIntersection(lines[deque[head]], lines[deque[head + 1]]))) {
+        head++;
+    }
+
+    if (tail - head < 3) {
+        return;
+    }
+
+    double area = 0;
+    for (int k = head; k < tail; k++) {
+        const auto& a = lines[deque[k]];
+        const auto& b = lines[deque[k + 1 < tail ? k + 1 : head]];
+        // neighbors facing opposite ways: the polygon has collapsed to a sliver
+        if (cross(a.d, b.d) <= 0) {
+            out.vertices.clear();
+            return;
+        }
+        out.vertices.push_back(lineIntersection(a, b));
+    }
+    for (size_t k = 0; k < out.vertices.size(); k++) {
+        area += cross(out.vertices[k], out.vertices[(k + 1) % out.vertices.size()]);
+    }
+
+    // the sweep cannot tell an empty intersection apart, it shows up as a polygon that
+    // winds the wrong way
+    if (area <= 0) {
+        out.vertices.clear();
+        return;
+    }
+
+    if (winding < 0) {
+        std::reverse(out.vertices.begin(), out.vertices.end());
+    }
+}
+
+bool isConvex(const Polygon& polygon)
+{
+    const auto& v = polygon.vertices;
+    const int n = static_cast<int>(v.size());
+    if (n < 3) {
+        return false;
+    }
+
+    // every turn goes the same way, and the edge directions sweep around only once:
+    // their x and y components change sign at most twice each
+    int turn = 0;
+    int xChanges = 0, yChanges = 0;
+    int xSign = 0, ySign = 0, firstXSign = 0, firstYSign = 0;
+    Point previous{};
+    bool hasPrevious = false;
+
+    auto sign = [](double x) { return (x > 0) - (x < 0); };
+    auto track = [](int s, int& current, int& first, int& changes) {
+        if (s == 0) {
+            return;
+        }
+        if (current == 0) {
+            first = s;
+        }
+        else if (s != current) {
+            changes++;
+        }
+        current = s;
+    };
+
+    for (int i = 0; i < n; i++) {
+        auto e = v[(i + 1) % n] - v[i];
+        if (e.x == 0 && e.y == 0) {
+            continue;
+        }
+        if (hasPrevious) {
+            int s = sign(cross(previous, e));
+            if (s != 0) {
+                if (turn != 0 && s != turn) {
+                    return false;
+                }
+                turn = s;
+            }
+        }
+        track(sign(e.x), xSign, firstXSign, xChanges);
+        track(sign(e.y), ySign, firstYSign, yChanges);
+        previous = e;
+        hasPrevious = true;
+    }
+
+    // close the loop: the last edge turns into the first one
+    for (int i = 0; i < n; i++) {
+        auto e = v[(i + 1) % n] - v[i];
+        if (e.x == 0 && e.y == 0) {
+            continue;
+        }
+        int s = sign(cross(previous, e));
+        if (s != 0 && turn != 0 && s != turn) {
+            return false;
+        }
+        break;
+    }
+    xChanges += xSign != 0 && xSign != firstXSign;
+    yChanges += ySign != 0 && ySign != firstYSign;
+
+    return turn != 0 && xChanges <= 2 && yChanges <= 2;
+}
+
 int windingDirection(const Polygon& polygon)
 {
     double sum = 0;
@@ -195,37 +512,70 @@ int windingDirection(const Polygon& polygon)
     return sum > 0 ? 1 : -1;
 }
 
+bool convexContains(const Polygon& convex, const Point& p)
+{
+    const auto& v = convex.vertices;
+    for (size_t i = 0; i < v.size(); i++) {
+        if (cross(v[(i + 1) % v.size()] - v[i], p - v[i]) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void clipToBisector(std::vector<Point>& vertices, Point site, Point neighbor, std::vector<Point>& scratch)
+{
+    auto m = (site + neighbor) * 0.5;
+    auto n = neighbor - site;
+
+    scratch.clear();
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto p = vertices[i];
+        auto q = vertices[(i + 1) % vertices.size()];
+        double dp = dot(p - m, n);
+        double dq = dot(q - m, n);
+        if (dp <= 0) {
+            scratch.push_back(p);
+        }
+        if ((dp < 0 && dq > 0) || (dp > 0 && dq < 0)) {
+            scratch.push_back(p + (q - p) * (dp / (dp - dq)));
+        }
+    }
+    vertices.swap(scratch);
+}
+
 bool intersect(const Segment& s1, const Segment& s2, Point& outIntersection) {
     auto& p1 = s1.v1;
     auto& q1 = s1.v2;
     auto& p2 = s2.v1;
     auto& q2 = s2.v2;
 
-    auto r = q1 - p1;
-    auto s = q2 - p2;
+    // decide with exact orientations, so that touching and nearly parallel segments are
+    // classified consistently, then compute the point in floating point
+    double o1 = orient2d(p1, q1, p2);
+    double o2 = orient2d(p1, q1, q2);
+    double o3 = orient2d(p2, q2, p1);
+    double o4 = orient2d(p2, q2, q1);
 
-    auto rxs = cross(r, s);
-    auto qmp = p2 - p1;
-
-    if (rxs == 0 && cross(qmp, r) == 0) {
+    if (o1 == 0 && o2 == 0) {
         // collinear
         return false;
     }
 
-    if (rxs == 0 && cross(qmp, r) != 0) {
-        // parallel
+    if ((o1 > 0 && o2 > 0) || (o1 < 0 && o2 < 0) || (o3 > 0 && o4 > 0) || (o3 < 0 && o4 < 0)) {
+        // apart, or parallel
         return false;
     }
 
-    auto t = cross(qmp, s) / rxs;
-    auto u = cross(qmp, r) / rxs;
-
-    if (t >= 0 && t <= 1 && u >= 0 && u <= 1) {
-        outIntersection = p1 + r * t;
-        return true;
-    }
+    auto r = q1 - p1;
+    auto s = q2 - p2;
+    auto rxs = cross(r, s);
+    auto qmp = p2 - p1;
 
-    return false;
+    // rxs can only round to zero when the segments are all but parallel
+    auto t = rxs != 0 ? std::clamp(cross(qmp, s) / rxs, 0.0, 1.0) : 0.0;
+    outIntersection = p1 + r * t;
+    return true;
 }
 
 } // namespace tora::geometry
@@ -90,6 +90,13 @@ struct Segment
     Point v2;
 };
 
+// axis-aligned, closed
+struct Rect
+{
+    Point min;
+    Point max;
+};
+
 struct Polygon
 {
     std::vector<Point> vertices;
@@ -98,8 +105,25 @@ struct Polygon
 };
 
 // shrinks clockwise polygons, inflates counter-clockwise polygons
+// Convex polygons are dispatched to offsetConvex.
 Polygon offset(const Polygon& polygon, double amount);
 
+// offset() for convex polygons in O(n), writing into out and reusing its storage.
+// Shrinking intersects the shifted edge half-planes, so corners are mitred and edges that
+// collapse drop out; out is left empty if the whole polygon does. Inflating keeps both
+// shifted ends of every edge (bevel joins), vertex for vertex what offset() produces.
+void offsetConvex(const Polygon& polygon, double amount, Polygon& out);
+
+// simple and convex, either winding; collinear and repeated vertices are allowed
+bool isConvex(const Polygon& polygon);
+
 int windingDirection(const Polygon& polygon);
 
+// p inside or on the border of a convex polygon with positive winding
+bool convexContains(const Polygon& convex, const Point& p);
+
+// Cuts a convex polygon down to the half-plane closer to site than to neighbor.
+// scratch is only reused storage, its contents are swapped out.
+void clipToBisector(std::vector<Point>& vertices, Point site, Point neighbor, std::vector<Point>& scratch);
+
 } // namespace tora::geometry
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "FlatHashMap.h"
+
+namespace tora::sim {
+
+	struct GridKey {
+		int gridX;
+		int gridY;
+
+		explicit GridKey(int x, int y) : gridX{ x }, gridY{ y } {}
+
+		// Both coordinates in one integer, x in the high half.
+		uint64_t packed() const {
+			return (static_cast<uint64_t>(static_cast<uint32_t>(gridX)) << 32) | static_cast<uint32_t>(gridY);
+		}
+
+		static GridKey unpack(uint64_t key) {
+			return GridKey{ static_cast<int>(static_cast<uint32_t>(key >> 32)), static_cast<int>(static_cast<uint32_t>(key)) };
+		}
+
+		bool operator==(const GridKey& other) const {
+			return gridX == other.gridX && gridY == other.gridY;
+		}
+
+		bool operator!=(const GridKey& other) const {
+			return !(*this == other);
+		}
+
+		inline bool isInside(int centerX, int centerY, int radius) const {
+			return centerX - radius <= gridX && gridX <= centerX + radius &&
+				centerY - radius <= gridY && gridY <= centerY + radius;
+		}
+	};
+
+	struct VertexKey {
+		GridKey g;
+		int index;
+
+		explicit VertexKey(int gx, int gy, int i) : g{ gx, gy }, index{ i } {}
+
+		bool operator==(const VertexKey& other) const {
+			return g == other.g && index == other.index;
+		}
+
+		bool operator!=(const VertexKey& other) const {
+			return !(*this == other);
+		}
+	};
+
+	struct EdgeKey {
+		VertexKey a;
+		VertexKey b;
+
+		explicit EdgeKey(VertexKey a, VertexKey b) : a{ a }, b{ b } {}
+
+		bool operator==(const EdgeKey& other) const {
+			return a == other.a && b == other.b;
+		}
+
+		bool operator!=(const EdgeKey& other) const {
+			return !(*this == other);
+		}
+	};
+
+} // namespace tora::sim
+
+
+namespace std {
+	// All three go through mix64 so nearby chunks spread over the whole table, at any
+	// width of size_t.
+	template <>
+	struct hash<tora::sim::GridKey> {
+		size_t operator()(const tora::sim::GridKey& k) const {
+			return static_cast<size_t>(tora::mix64(k.packed()));
+		}
+	};
+
+	template <>
+	struct hash<tora::sim::VertexKey> {
+		size_t operator()(const tora::sim::VertexKey& k) const {
+			return static_cast<size_t>(tora::mix64(k.g.packed() ^ tora::mix64(static_cast<uint32_t>(k.index))));
+		}
+	};
+
+	template <>
+	struct hash<tora::sim::EdgeKey> {
+		size_t operator()(const tora::sim::EdgeKey& k) const {
+			uint64_t a = tora::mix64(k.a.g.packed() ^ tora::mix64(static_cast<uint32_t>(k.a.index)));
+			uint64_t b = tora::mix64(k.b.g.packed() ^ tora::mix64(static_cast<uint32_t>(k.b.index)));
+			return static_cast<size_t>(tora::mix64(a + 0x9e3779b97f4a7c15ull * b));
+		}
+	};
+} // namespace std
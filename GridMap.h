@@ -1,10 +1,24 @@
 #pragma once
 
 #include "VectorMath.h"
+#include "ChunkSpill.h"
+#include "Epoch.h"
+#include "FlatHashMap.h"
+#include "GridKey.h"
+#include "IncrementalDelaunay.h"
+#include "PoissonDisk.h"
 #include "Random.h"
-#include "delaunator.hpp"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <filesystem>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
+#include <span>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 #include <algorithm>
@@ -15,299 +29,931 @@
 
 namespace tora::sim {
 
-	struct GridKey {
-		int gridX;
-		int gridY;
+	// A chunk's vertices and the edges at them.
+	//
+	// Edges between two of the chunk's vertices are stored once, from the lower index, as
+	// CSR: the neighbors of vertex i above it are localTargets_[localOffsets_[i] ..
+	// localOffsets_[i + 1]). An edge to another chunk is stored as a half-edge in each of the
+	// two, in one bucket per offset to the other chunk, so removing one searches only the
+	// edges towards that chunk. Vertex indices are 16 bits; a chunk holds a handful of
+	// vertices.
+	class TriangulationGrid {
+	public:
+		// edges reach at most this many chunks away on either axis
+		static const int kMaxReach = 2;
 
-		explicit GridKey(int x, int y) : gridX{ x }, gridY{ y } {}
+		TriangulationGrid(int xIndex, int yIndex) : xIndex_{ xIndex }, yIndex_{ yIndex } {
+			localOffsets_.push_back(0);
+			crossOffsets_.fill(0);
+		}
 
-		bool operator==(const GridKey& other) const {
-			return gridX == other.gridX && gridY == other.gridY;
+		TriangulationGrid(int xIndex, int yIndex, std::vector<Vec2f> vertices, std::span<const EdgeKey> edges)
+			: TriangulationGrid(xIndex, yIndex) {
+			vertices_ = std::move(vertices);
+			assert(vertices_.size() <= UINT16_MAX);
+			localOffsets_.assign(vertices_.size() + 1, 0);
+			for (const auto& e : edges) {
+				addEdge(e);
+			}
 		}
 
-		bool operator!=(const GridKey& other) const {
-			return !(*this == other);
+		void addVertex(Vec2f vert) {
+			assert(vertices_.size() < UINT16_MAX);
+			vertices_.emplace_back(vert);
+			localOffsets_.push_back(localOffsets_.back());
 		}
 
-		inline bool isInside(int centerX, int centerY, int radius) const {
-			return centerX - radius <= gridX && gridX <= centerX + radius &&
-				centerY - radius <= gridY && gridY <= centerY + radius;
+		// Adds the edge, which starts at this chunk. An edge inside the chunk is added once,
+		// whichever end comes first.
+		void addEdge(EdgeKey edge) {
+			// indices and offsets are 16 bits
+			assert(edge.a.index < static_cast<int>(vertices_.size()) && edge.b.index <= UINT16_MAX);
+			assert(edgeCount() < UINT16_MAX);
+			if (edge.b.g == getKey()) {
+				auto [a, b] = std::minmax(edge.a.index, edge.b.index);
+				localTargets_.insert(localTargets_.begin() + localOffsets_[a + 1], static_cast<uint16_t>(b));
+				for (size_t i = a + 1; i < localOffsets_.size(); i++) {
+					localOffsets_[i]++;
+				}
+				return;
+			}
+			const int bucket = bucketOf(edge.b.g);
+			crossEdges_.insert(crossEdges_.begin() + crossOffsets_[bucket + 1],
+				CrossEdge{ static_cast<uint16_t>(edge.a.index), static_cast<uint16_t>(edge.b.index) });
+			for (int i = bucket + 1; i <= kBuckets; i++) {
+				crossOffsets_[i]++;
+			}
 		}
-	};
 
-	struct VertexKey {
-		GridKey g;
-		int index;
+		void removeEdge(EdgeKey edge) {
+			if (edge.b.g == getKey()) {
+				auto [a, b] = std::minmax(edge.a.index, edge.b.index);
+				auto first = localTargets_.begin() + localOffsets_[a];
+				auto it = std::find(first, localTargets_.begin() + localOffsets_[a + 1], b);
+				if (it != localTargets_.begin() + localOffsets_[a + 1]) {
+					localTargets_.erase(it);
+					for (size_t i = a + 1; i < localOffsets_.size(); i++) {
+						localOffsets_[i]--;
+					}
+				}
+				return;
+			}
+			const int bucket = bucketOf(edge.b.g);
+			auto first = crossEdges_.begin() + crossOffsets_[bucket];
+			auto last = crossEdges_.begin() + crossOffsets_[bucket + 1];
+			auto it = std::find_if(first, last, [&](const CrossEdge& e) {
+				return e.a == edge.a.index && e.b == edge.b.index;
+			});
+			if (it != last) {
+				crossEdges_.erase(it);
+				for (int i = bucket + 1; i <= kBuckets; i++) {
+					crossOffsets_[i]--;
+				}
+			}
+		}
 
-		explicit VertexKey(int gx, int gy, int i) : g{ gx, gy }, index{ i } {}
+		const std::vector<Vec2f>& vertices() const {
+			return vertices_;
+		}
 
-		bool operator==(const VertexKey& other) const {
-			return g == other.g && index == other.index;
+		// f(EdgeKey) for every edge inside the chunk, once, and every edge from it to
+		// another chunk; each starts at this chunk.
+		template <class F>
+		void forEachEdge(F&& f) const {
+			for (int a = 0; a + 1 < static_cast<int>(localOffsets_.size()); a++) {
+				for (int i = localOffsets_[a]; i < localOffsets_[a + 1]; i++) {
+					f(EdgeKey{ getVertexKey(a), getVertexKey(localTargets_[i]) });
+				}
+			}
+			for (int bucket = 0; bucket < kBuckets; bucket++) {
+				const int dx = bucket % kBucketSide - kMaxReach;
+				const int dy = bucket / kBucketSide - kMaxReach;
+				for (int i = crossOffsets_[bucket]; i < crossOffsets_[bucket + 1]; i++) {
+					const auto& e = crossEdges_[i];
+					f(EdgeKey{ getVertexKey(e.a), VertexKey{ xIndex_ + dx, yIndex_ + dy, e.b } });
+				}
+			}
 		}
 
-		bool operator!=(const VertexKey& other) const {
-			return !(*this == other);
+		size_t edgeCount() const {
+			return localTargets_.size() + crossEdges_.size();
 		}
-	};
 
-	struct EdgeKey {
-		VertexKey a;
-		VertexKey b;
+		GridKey getKey() const {
+			return GridKey{ xIndex_, yIndex_ };
+		}
 
-		explicit EdgeKey(VertexKey a, VertexKey b) : a{ a }, b{ b } {}
+		VertexKey getVertexKey(int index) const {
+			return VertexKey{ xIndex_, yIndex_, index };
+		}
 
-		bool operator==(const EdgeKey& other) const {
-			return a == other.a && b == other.b;
+		// heap and object bytes held by the chunk
+		size_t bytes() const {
+			return sizeof(*this) + vertices_.capacity() * sizeof(Vec2f)
+				+ localOffsets_.capacity() * sizeof(uint16_t) + localTargets_.capacity() * sizeof(uint16_t)
+				+ crossEdges_.capacity() * sizeof(CrossEdge);
 		}
 
-		bool operator!=(const EdgeKey& other) const {
-			return !(*this == other);
+	private:
+		static const int kBucketSide = 2 * kMaxReach + 1;
+		static const int kBuckets = kBucketSide * kBucketSide;
+
+		struct CrossEdge {
+			uint16_t a; // here
+			uint16_t b; // in the bucket's chunk
+		};
+
+		int bucketOf(const GridKey& other) const {
+			assert(std::abs(other.gridX - xIndex_) <= kMaxReach && std::abs(other.gridY - yIndex_) <= kMaxReach);
+			return (other.gridY - yIndex_ + kMaxReach) * kBucketSide + (other.gridX - xIndex_ + kMaxReach);
 		}
+
+		int xIndex_;
+		int yIndex_;
+		std::vector<Vec2f> vertices_;
+		std::vector<uint16_t> localOffsets_;         // per vertex, and one past the last
+		std::vector<uint16_t> localTargets_;
+		std::array<uint16_t, kBuckets + 1> crossOffsets_; // per offset to another chunk, row by row
+		std::vector<CrossEdge> crossEdges_;
 	};
 
-} // namespace tora
+	// Every published chunk at one point in time. Snapshots never change once published,
+	// so they are read without locks; see TriangulationGridMap::snapshot().
+	//
+	// Chunks are stored in square regions of kRegionSize chunks a side. Snapshots share
+	// unchanged regions and chunks, so a new one copies only the region table and the
+	// regions and chunks it replaces.
+	class GridSnapshot {
+	public:
+		const TriangulationGrid* find(int gx, int gy) const {
+			const auto* region = regions_.find(regionKey(gx, gy));
+			return region ? (*region)->grids[slotOf(gx, gy)].get() : nullptr;
+		}
+
+		size_t size() const {
+			return size_;
+		}
+
+		// Chunks within r of (x, y), not counting itself.
+		std::vector<const TriangulationGrid*> getNeighborGrids(int x, int y, int r) const {
+			auto result = std::vector<const TriangulationGrid*>{};
+			const int r2 = (r * 2 + 1) * (r * 2 + 1);
+			if (r2 <= 100) result.reserve(r2);
+
+			int sx = x - r;
+			int ex = x + r + 1;
+			int sy = y - r;
+			int ey = y + r + 1;
 
+			for (int tx = sx; tx < ex; tx++) {
+				for (int ty = sy; ty < ey; ty++) {
+					if (tx == x && ty == y)
+						continue;
 
-namespace std {
-	template <>
-	struct hash<tora::sim::GridKey> {
-		size_t operator()(const tora::sim::GridKey& k) const {
-			return std::hash<int>{}(k.gridX) ^ (std::hash<int>{}(k.gridY) << 8);
+					if (auto* grid = find(tx, ty)) {
+						result.push_back(grid);
+					}
+				}
+			}
+
+			return result;
 		}
-	};
 
-	template <>
-	struct hash<tora::sim::VertexKey> {
-		size_t operator()(const tora::sim::VertexKey& k) const {
-			return (std::hash<tora::sim::GridKey>{}(k.g) << 5) ^ (std::hash<int>{}(k.index));
+		// f(const TriangulationGrid&) for every chunk
+		template <class F>
+		void forEach(F&& f) const {
+			regions_.forEach([&](uint64_t, const std::shared_ptr<const Region>& region) {
+				for (const auto& grid : region->grids) {
+					if (grid) f(*grid);
+				}
+			});
 		}
-	};
 
-	template <>
-	struct hash<tora::sim::EdgeKey> {
-		size_t operator()(const tora::sim::EdgeKey& k) const {
-			return std::hash<tora::sim::VertexKey>{}(k.a) ^ (std::hash<tora::sim::VertexKey>{}(k.b) << 32);
+	private:
+		friend class TriangulationGridMap;
+
+		static const int kRegionShift = 3;
+		static const int kRegionSize = 1 << kRegionShift;
+
+		struct Region {
+			std::array<std::shared_ptr<const TriangulationGrid>, kRegionSize * kRegionSize> grids;
+		};
+
+		static uint64_t regionKey(int gx, int gy) {
+			// arithmetic shifts round towards -inf, so negative chunks group like positive ones
+			return GridKey{ gx >> kRegionShift, gy >> kRegionShift }.packed();
 		}
-	};
-} // namespace std
 
-namespace tora::sim {
+		static int slotOf(int gx, int gy) {
+			return (gy & (kRegionSize - 1)) * kRegionSize + (gx & (kRegionSize - 1));
+		}
 
-	class TriangulationGrid {
+		// Puts grid, or nothing if it is null, at (gx, gy). A region is copied the first time a write touches it;
+		// copied tracks those copies across calls.
+		void set(int gx, int gy, std::shared_ptr<const TriangulationGrid> grid, FlatHashMap<Region*>& copied) {
+			const uint64_t key = regionKey(gx, gy);
+			Region* region = nullptr;
+			if (auto* own = copied.find(key)) {
+				region = *own;
+			}
+			else {
+				const auto* shared = regions_.find(key);
+				auto copy = shared ? std::make_shared<Region>(**shared) : std::make_shared<Region>();
+				region = copy.get();
+				regions_[key] = std::move(copy);
+				copied.tryEmplace(key, region);
+			}
+			auto& slot = region->grids[slotOf(gx, gy)];
+			size_ = size_ + (grid ? 1 : 0) - (slot ? 1 : 0);
+			slot = std::move(grid);
+		}
+
+		FlatHashMap<std::shared_ptr<const Region>> regions_;
+		size_t size_ = 0;
+	};
+
+	// Chunks are generated on a thread pool, in two phases.
+	//
+	// Compute samples the chunk's vertices, a function of the seed and the chunk's
+	// coordinates alone; see sampleGrid().
+	//
+	// Publish inserts the vertices, and those of the chunks around it (see kHaloRadius), into
+	// one Delaunay triangulation of the map, which only repairs the triangles around them.
+	// The chunk takes its edges from the triangulation, and the edges that appeared and
+	// disappeared become edits of the other chunks they belong to. The edited chunks are
+	// copies; they go into a new snapshot that is then swapped in. Readers keep whichever snapshot
+	// they pinned, so they never wait for writers and never see a chunk half done. Old
+	// snapshots go back to EpochDomain, which frees them once the last reader that might
+	// hold them unpins.
+	//
+	// Under a memory budget, chunks that no viewer has been near for longest are evicted to
+	// a ChunkSpill file, and read back when requested again; a chunk's edges are final once
+	// it is published, so evicted chunks are never edited. Snapshots simply lack evicted
+	// chunks. The triangulation keeps only the chunks in memory and those around them, and
+	// drops the rest now and then; see setMemoryBudget(). A chunk whose record cannot be
+	// read back is computed again.
+	//
+	// Chunks are computed in any order, and published in whatever order they finish.
+	// Vertices depend only on the seed, and the Delaunay triangulation of them does not
+	// depend on the order they were inserted, so neither do the edges.
+	class TriangulationGridMap {
 	public:
-		TriangulationGrid(int xIndex, int yIndex) : xIndex_{ xIndex }, yIndex_{ yIndex } {}
+		explicit TriangulationGridMap(ThreadPool& pool = ThreadPool::shared())
+			: TriangulationGridMap(Random()(), pool) {}
+
+		explicit TriangulationGridMap(uint64_t seed, ThreadPool& pool = ThreadPool::shared())
+			: seed_{ seed }, pool_{ pool } {}
+
+		// Readers may still hold snapshots, of this map or others, so the last snapshot is
+		// retired like the ones before it rather than waited out. Chunks are owned by the
+		// snapshots and go with them.
+		~TriangulationGridMap() {
+			try {
+				waitIdle();
+			}
+			catch (...) {
+				// already reported by waitIdle or buildGrid, or nobody asked
+			}
+			const auto* last = current_.load();
+			EpochDomain::shared().retire([last] { delete last; });
+		}
 
-		void addVertex(Vec2f vert) {
-			vertices_.emplace_back(vert);
+		// The published chunks, pinned: pointers taken from it stay valid and unchanged for
+		// as long as it is alive. Keep it short-lived, it holds back reclamation.
+		class Snapshot {
+		public:
+			const GridSnapshot* operator->() const { return snapshot_; }
+			const GridSnapshot& operator*() const { return *snapshot_; }
+
+		private:
+			friend class TriangulationGridMap;
+			Snapshot(EpochDomain::Guard guard, const GridSnapshot* snapshot)
+				: guard_{ std::move(guard) }, snapshot_{ snapshot } {}
+
+			EpochDomain::Guard guard_;
+			const GridSnapshot* snapshot_;
+		};
+
+		Snapshot snapshot() const {
+			auto guard = EpochDomain::shared().pin();
+			return Snapshot{ std::move(guard), current_.load() };
 		}
 
-		void addEdge(EdgeKey edge) {
-			edges_.emplace_back(edge);
+		TriangulationGridMap(const TriangulationGridMap&) = delete;
+		TriangulationGridMap& operator=(const TriangulationGridMap&) = delete;
+
+		// Queues chunk (gx, gy) for generation unless it exists or is queued already.
+		void requestGrid(int gx, int gy) {
+			const uint64_t key = GridKey{ gx, gy }.packed();
+			{
+				std::lock_guard lock{ scheduleMutex_ };
+				// a request leaves requests_ only after its chunk is published
+				if (requests_.contains(key) || hasGrid(gx, gy)) {
+					return;
+				}
+				requests_.tryEmplace(key, 1);
+			}
+			startGrid(gx, gy);
 		}
 
-		void breakEdgesTowards(int gx, int gy, int radius) {
-			edges_.erase(
-				std::remove_if(edges_.begin(), edges_.end(), [&](const EdgeKey& e) {
-					return e.b.g.isInside(gx, gy, radius);
-				}),
-				edges_.end());
+		// requestGrid, then runs pool tasks until the chunk is published. Under a memory
+		// budget it may be evicted again right after, unless a viewer is near it. Rethrows
+		// the first error any chunk task ran into.
+		void buildGrid(int gx, int gy) {
+			requestGrid(gx, gy);
+			const uint64_t key = GridKey{ gx, gy }.packed();
+			while (true) {
+				{
+					std::lock_guard lock{ scheduleMutex_ };
+					if (error_) {
+						std::rethrow_exception(error_);
+					}
+					if (!requests_.contains(key)) {
+						return;
+					}
+				}
+				if (!pool_.runPendingTask()) {
+					std::this_thread::yield();
+				}
+			}
 		}
 
-		void breakFarEdges(int threshold) {
-			edges_.erase(
-				std::remove_if(edges_.begin(), edges_.end(), [&](const EdgeKey& e) {
-					return abs(xIndex_ - e.b.g.gridX) > threshold ||
-						abs(yIndex_ - e.b.g.gridY) > threshold;
-					}),
-				edges_.end());
+		// Whether the chunk is published and in memory.
+		bool hasGrid(int gx, int gy) const {
+			return snapshot()->find(gx, gy) != nullptr;
 		}
 
-		const std::vector<Vec2f>& vertices() const {
-			return vertices_;
+		// The vertices of chunk (gx, gy) in a map with the given seed, whatever else exists.
+		//
+		// Chunks are sampled in four phases by the parity of their coordinates, as in Wei's
+		// "Parallel Poisson Disk Sampling": a chunk is sampled against the vertices of its
+		// neighbors in earlier phases, and ignores those in later phases, which are sampled
+		// against it. Chunks of one phase are a chunk apart, further than the sampling
+		// distance, so they never interact. Each chunk draws from a generator seeded by
+		// hashing the seed with its coordinates, so its vertices are a function of those
+		// and of its earlier-phase neighbors', which recursively are too.
+		//
+		// In isolation a chunk costs up to 17 samplings, for its earlier-phase neighbors
+		// and theirs; the map reuses the ones it has at hand instead.
+		static std::vector<Vec2f> sampleGrid(uint64_t seed, int gx, int gy) {
+			auto memo = FlatHashMap<std::vector<Vec2f>>{};
+			return sampleGrid(seed, GridKey{ gx, gy }, memo, [](const GridKey&, std::vector<Vec2f>&) { return false; });
 		}
 
-		const std::vector<EdgeKey>& edges() const {
-			return edges_;
+		// Keeps chunks in memory within about bytes, evicting the least recently viewed ones
+		// that are further than keepRadius chunks from every viewer to a file at spillPath,
+		// or a temporary file if it is empty. The file is created by the first call and kept
+		// for the map's lifetime; later calls only change the limits. Throws
+		// std::runtime_error if the file cannot be created.
+		//
+		// The budget caps chunk payloads only, as residentBytes() counts them. Besides those,
+		// the triangulation and the records beside it take about 90 bytes per vertex, some
+		// 400 per chunk, for the chunks in memory and the two rings around them. Chunks
+		// evicted since the last trim stay in it until it doubles, or holds kMinTrimVertices,
+		// so it stays within a few times the size the chunks in memory need.
+		void setMemoryBudget(size_t bytes, int keepRadius = 4, std::filesystem::path spillPath = {}) {
+			std::lock_guard lock{ publishMutex_ };
+			budget_ = bytes;
+			keepRadius_ = keepRadius;
+			if (!spill_) {
+				spill_ = std::make_unique<ChunkSpill>(std::move(spillPath));
+			}
+			auto edit = beginEdit();
+			commitEdit(edit);
 		}
 
-		bool hasNearbyVertex(Vec2f vert, float minDistance) const {
-			float m2 = minDistance * minDistance;
-			for (const auto& v : vertices_) {
-				if (distanceSqr(v, vert) < m2) {
-					return true;
+		// The chunks viewers are at. Chunks within keepRadius of one are never evicted, and
+		// count as used now.
+		void setViewers(std::span<const GridKey> viewers) {
+			std::lock_guard lock{ publishMutex_ };
+			viewers_.assign(viewers.begin(), viewers.end());
+			tick_++;
+			for (const auto& v : viewers_) {
+				for (int ty = v.gridY - keepRadius_; ty <= v.gridY + keepRadius_; ty++) {
+					for (int tx = v.gridX - keepRadius_; tx <= v.gridX + keepRadius_; tx++) {
+						if (auto* resident = resident_.find(GridKey{ tx, ty }.packed())) {
+							resident->lastUse = tick_;
+						}
+					}
 				}
 			}
-			return false;
 		}
 
-		GridKey getKey() const {
-			return GridKey{ xIndex_, yIndex_ };
+		// bytes held by the chunks in memory, as counted against the budget
+		size_t residentBytes() const {
+			std::lock_guard lock{ publishMutex_ };
+			return residentBytes_;
 		}
 
-		VertexKey getVertexKey(int index) const {
-			return VertexKey{ xIndex_, yIndex_, index };
+		size_t evictedGrids() const {
+			std::lock_guard lock{ publishMutex_ };
+			return spill_ ? spill_->size() : 0;
+		}
+
+		// Runs pool tasks until every requested chunk is published. Rethrows the first error
+		// any chunk task ran into.
+		void waitIdle() {
+			while (true) {
+				{
+					std::lock_guard lock{ scheduleMutex_ };
+					if (error_) {
+						std::rethrow_exception(error_);
+					}
+					if (requests_.empty()) {
+						return;
+					}
+				}
+				if (!pool_.runPendingTask()) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		void render(sf::RenderWindow& window) {
+			auto snapshot = this->snapshot();
+			snapshot->forEach([&](const TriangulationGrid& grid) {
+				grid.forEachEdge([&](const EdgeKey& e) {
+					if (e.a.g.gridY > e.b.g.gridY || e.a.g.gridY == e.b.g.gridY && e.a.g.gridX > e.b.g.gridX) {
+						// Edges between chunks are stored as two half-edges, one from each
+						// end. Establish a consistent rule to draw only one of them.
+						return;
+					}
+					// edges are stored with the grid of their first end
+					const auto* other = snapshot->find(e.b.g.gridX, e.b.g.gridY);
+					if (!other) {
+						// evicted, or not published yet
+						return;
+					}
+					const auto& v1 = grid.vertices()[e.a.index];
+					const auto& v2 = other->vertices()[e.b.index];
+					sf::Vertex line[] = {
+						sf::Vertex(v1),
+						sf::Vertex(v2),
+					};
+					window.draw(line, 2, sf::Lines);
+				});
+			});
 		}
 
 	private:
-		int xIndex_;
-		int yIndex_;
-		std::vector<Vec2f> vertices_;
-		std::vector<EdgeKey> edges_;
-	};
+		void startGrid(int gx, int gy) {
+			pool_.submit([this, gx, gy] {
+				try {
+					if (!reloadGrid(gx, gy)) {
+						publishGrid(GridKey{ gx, gy }, computeGrid(gx, gy));
+					}
+				}
+				catch (...) {
+					// nothing waits on the task's future; waitIdle and buildGrid rethrow it
+					std::lock_guard lock{ scheduleMutex_ };
+					if (!error_) {
+						error_ = std::current_exception();
+					}
+				}
+				finishGrid(gx, gy);
+			});
+		}
 
-	class TriangulationGridMap {
-	public:
-		void buildGrid(int gx, int gy) {
-			auto g = std::make_unique<TriangulationGrid>(gx, gy);
+		// Samples chunk (gx, gy), and the chunks around it that publishing it inserts into
+		// the triangulation too.
+		std::vector<Vec2f> computeGrid(int gx, int gy) {
+			TORA_TRACE(Debug, "building grid (%d, %d)", gx, gy);
+
+			auto known = [this](const GridKey& k, std::vector<Vec2f>& out) {
+				std::lock_guard lock{ publishMutex_ };
+				return knownVertices(k, out);
+			};
+			auto memo = FlatHashMap<std::vector<Vec2f>>{};
+			auto vertices = sampleGrid(seed_, GridKey{ gx, gy }, memo, known);
+			for (int ty = gy - kHaloRadius; ty <= gy + kHaloRadius; ty++) {
+				for (int tx = gx - kHaloRadius; tx <= gx + kHaloRadius; tx++) {
+					sampleGrid(seed_, GridKey{ tx, ty }, memo, known);
+				}
+			}
+			std::lock_guard lock{ publishMutex_ };
+			keepSampled(memo);
+			return vertices;
+		}
+
+		// Chunks sampled before, inserted or not, have the vertices sampling them again
+		// would give. Under publishMutex_.
+		bool knownVertices(const GridKey& k, std::vector<Vec2f>& out) const {
+			if (const auto* range = chunkVertices_.find(k.packed())) {
+				auto begin = vertexPositions_.begin() + range->first;
+				out.assign(begin, begin + range->count);
+				return true;
+			}
+			if (const auto* vertices = sampled_.find(k.packed())) {
+				out = *vertices;
+				return true;
+			}
+			return false;
+		}
+
+		// Keeps the chunks sampled into memo that are not in the triangulation, for whichever
+		// publish inserts them. Under publishMutex_.
+		void keepSampled(FlatHashMap<std::vector<Vec2f>>& memo) {
+			memo.forEach([&](uint64_t key, std::vector<Vec2f>& v) {
+				if (!chunkVertices_.contains(key) && !sampled_.contains(key)) {
+					sampled_.tryEmplace(key, std::move(v));
+				}
+			});
+		}
 
-			// Generate K vertices
-			for (int i = 0; i < kVerticesPerGrid; i++) {
-				for (int t = 0; t < kPutVertexMaxRetries; t++) {
-					// TODO: Tweak random so we don't get close-to-border verts
-					auto vx = kGridSize * random_.getRandomBetween(0.2f, 0.8f);
-					auto vy = kGridSize * random_.getRandomBetween(0.2f, 0.8f);
-					auto v = Vec2f{ gx * kGridSize + vx, gy * kGridSize + vy };
+		static int phaseOf(const GridKey& k) {
+			return (k.gridX & 1) + 2 * (k.gridY & 1);
+		}
+
+		// Samples chunk k after its earlier-phase neighbors, memoizing every chunk it
+		// samples. known(k, out) fills out with a chunk's vertices if they are at hand.
+		template <class Known>
+		static std::vector<Vec2f> sampleGrid(uint64_t seed, const GridKey& k, FlatHashMap<std::vector<Vec2f>>& memo, const Known& known) {
+			if (const auto* done = memo.find(k.packed())) {
+				return *done;
+			}
+			auto vertices = std::vector<Vec2f>{};
+			if (!known(k, vertices)) {
+				auto fixed = std::vector<Vec2f>{};
+				const int phase = phaseOf(k);
+				for (int ty = k.gridY - 1; ty <= k.gridY + 1; ty++) {
+					for (int tx = k.gridX - 1; tx <= k.gridX + 1; tx++) {
+						const auto n = GridKey{ tx, ty };
+						if (phaseOf(n) < phase) {
+							auto nv = sampleGrid(seed, n, memo, known);
+							fixed.insert(fixed.end(), nv.begin(), nv.end());
+						}
+					}
+				}
+				thread_local auto sampler = PoissonDiskSampler{ kMinDistanceBetweenVertices };
+				auto random = Random{ mix64(seed ^ k.packed()) };
+				sampler.sample(Vec2f(k.gridX * kGridSize, k.gridY * kGridSize), kGridSize, fixed, random, vertices);
+			}
+			memo.tryEmplace(k.packed(), vertices);
+			return vertices;
+		}
+
+		// Whether chunk k is in memory or in the spill file. Under publishMutex_.
+		bool isPublished(const GridKey& k) const {
+			return resident_.contains(k.packed()) || (spill_ && spill_->contains(k));
+		}
+
+		void publishGrid(const GridKey& key, const std::vector<Vec2f>& vertices) {
+			std::lock_guard lock{ publishMutex_ };
+			if (isPublished(key)) {
+				// by an earlier request; its edges are final, and the neighbors have their halves
+				return;
+			}
+
+			auto edit = beginEdit();
+			insertAround(key, vertices);
+			applyChanges(edit);
+			auto built = rebuildGrid(key);
+			TORA_TRACE(Debug, "grid (%d, %d): %zu vertices, %zu edge changes, %zu chunks edited",
+				key.gridX, key.gridY, built->vertices().size(), changes_.size(), edit.grids.size());
+			putGrid(edit, std::move(built));
+			commitEdit(edit);
+		}
+
+		// Publishes chunk (gx, gy) again if it was evicted. Returns false if it needs
+		// computing: it was never published, or its record cannot be read back.
+		bool reloadGrid(int gx, int gy) {
+			std::lock_guard lock{ publishMutex_ };
+			const auto key = GridKey{ gx, gy };
+			if (!spill_ || !spill_->contains(key)) {
+				return false;
+			}
+			auto vertices = std::vector<Vec2f>{};
+			auto edges = std::vector<EdgeKey>{};
+			if (!spill_->read(key, vertices, edges)) {
+				TORA_TRACE(Info, "cannot read back grid (%d, %d), computing it again", gx, gy);
+				spill_->erase(key);
+				return false;
+			}
+
+			TORA_TRACE(Debug, "grid (%d, %d): reloaded", gx, gy);
+			auto edit = beginEdit();
+			insertAround(key, vertices);
+			applyChanges(edit);
+			putGrid(edit, std::make_unique<TriangulationGrid>(gx, gy, std::move(vertices), edges));
+			commitEdit(edit);
+			return true;
+		}
 
-					if (g->hasNearbyVertex(v, kMinDistanceBetweenVertices)) {
+		// Inserts the vertices of every chunk within kHaloRadius of k that the triangulation
+		// lacks, k's own being given, and leaves the edge changes in changes_.
+		void insertAround(const GridKey& k, const std::vector<Vec2f>& own) {
+			changes_.clear();
+			auto known = [this](const GridKey& c, std::vector<Vec2f>& out) {
+				return knownVertices(c, out);
+			};
+			auto memo = FlatHashMap<std::vector<Vec2f>>{};
+			for (int ty = k.gridY - kHaloRadius; ty <= k.gridY + kHaloRadius; ty++) {
+				for (int tx = k.gridX - kHaloRadius; tx <= k.gridX + kHaloRadius; tx++) {
+					const auto c = GridKey{ tx, ty };
+					if (chunkVertices_.contains(c.packed())) {
 						continue;
 					}
+					if (c == k) {
+						insertGrid(c, own, &changes_);
+					}
+					else {
+						// sampled by computeGrid unless the triangulation was trimmed since
+						insertGrid(c, sampleGrid(seed_, c, memo, known), &changes_);
+					}
+				}
+			}
+			keepSampled(memo);
+		}
 
-					g->addVertex(v);
-					break;
+		void insertGrid(const GridKey& k, std::span<const Vec2f> vertices, std::vector<geometry::IncrementalDelaunay::EdgeChange>* changes) {
+			// start the walks at a neighbor's vertex, so they stay short however big the map
+			int near = -1;
+			for (int ty = k.gridY - 1; ty <= k.gridY + 1 && near < 0; ty++) {
+				for (int tx = k.gridX - 1; tx <= k.gridX + 1 && near < 0; tx++) {
+					const auto* range = chunkVertices_.find(GridKey{ tx, ty }.packed());
+					if (range && range->count > 0) {
+						near = range->first;
+					}
 				}
 			}
 
-			// Triangulation
-			auto vertexKeys = std::vector<VertexKey>{};
-			auto vertexCoords = std::vector<double>{};
+			const int first = static_cast<int>(vertexKeys_.size());
 			int index = 0;
-			for (const auto& v : g->vertices()) {
-				vertexCoords.push_back(v.x);
-				vertexCoords.push_back(v.y);
-				vertexKeys.push_back(g->getVertexKey(index++));
-			}
-			for (auto* ng : getNeighborGrids(gx, gy, kMaxImpactRadiusHeuristic)) {
-				if (!ng) continue;
-				ng->breakEdgesTowards(gx, gy, kMaxImpactRadiusHeuristic);
-				index = 0;
-				for (const auto& v : ng->vertices()) {
-					vertexCoords.push_back(v.x);
-					vertexCoords.push_back(v.y);
-					vertexKeys.push_back(ng->getVertexKey(index++));
+			for (const auto& v : vertices) {
+				int id = triangulation_.insert(geometry::Point(v.x, v.y), changes, near);
+				if (id == static_cast<int>(vertexKeys_.size())) {
+					vertexKeys_.push_back(VertexKey{ k.gridX, k.gridY, index });
+					vertexPositions_.push_back(v);
 				}
+				near = id;
+				index++;
+			}
+			sampled_.erase(k.packed());
+			chunkVertices_.tryEmplace(k.packed(), VertexRange{ first, static_cast<int>(vertexKeys_.size()) - first });
+		}
+
+		// A snapshot being made from the current one, under publishMutex_.
+		struct Edit {
+			const GridSnapshot* old;
+			std::unique_ptr<GridSnapshot> next;
+			FlatHashMap<GridSnapshot::Region*> copied;
+			FlatHashMap<TriangulationGrid*> grids; // the new versions of the chunks it touches
+		};
+
+		Edit beginEdit() {
+			const auto* old = current_.load();
+			return Edit{ old, std::make_unique<GridSnapshot>(*old), {}, {} };
+		}
+
+		void putGrid(Edit& edit, std::unique_ptr<TriangulationGrid> grid) {
+			auto key = grid->getKey();
+			edit.grids.tryEmplace(key.packed(), grid.get());
+			edit.next->set(key.gridX, key.gridY, std::shared_ptr<const TriangulationGrid>(std::move(grid)), edit.copied);
+		}
+
+		// A new version of chunk k, copied from the one in memory; null if k is not in memory.
+		TriangulationGrid* editGrid(Edit& edit, const GridKey& k) {
+			if (auto* own = edit.grids.find(k.packed())) {
+				return *own;
+			}
+			const auto* resident = edit.old->find(k.gridX, k.gridY);
+			if (!resident) {
+				return nullptr;
 			}
+			auto grid = std::make_unique<TriangulationGrid>(*resident);
+			auto* result = grid.get();
+			putGrid(edit, std::move(grid));
+			return result;
+		}
 
-			double w = (kMaxImpactRadiusHeuristic * 2 + kArtificialHullExtension) * kGridSize;
-			double stepLength = w / kArtificialHullSteps;
-			double sx = (gx + 0.5) * kGridSize - 0.5 * w;
-			double sy = (gy + 0.5) * kGridSize - 0.5 * w;
-			for (int i = 0, xx = sx; i <= kArtificialHullSteps; i++, xx += stepLength) {
-				vertexCoords.push_back(xx);
-				vertexCoords.push_back(sy);
-				vertexCoords.push_back(xx);
-				vertexCoords.push_back(sy + w);
-			}
-			for (int i = 0, yy = sy; i <= kArtificialHullSteps; i++, yy += stepLength) {
-				vertexCoords.push_back(sx);
-				vertexCoords.push_back(yy);
-				vertexCoords.push_back(sx + w);
-				vertexCoords.push_back(yy);
-			}
-
-			auto dt = delaunator::Delaunator{ vertexCoords };
-
-			// Finalize and assign edges to grids.
-			
-			grids_.emplace(GridKey{ gx, gy }, std::move(g));
-			
-			for (int i = 0; i < dt.triangles.size(); i += 3) {
-				if (dt.triangles[i] >= vertexKeys.size() || dt.triangles[i + 1] >= vertexKeys.size() || dt.triangles[i + 2] >= vertexKeys.size()) {
-					// artificial triangle, skip
+		// Turns changes_ into edits of the chunks in memory. Both ends' chunks keep the edge,
+		// each with its own end first; a chunk keeps an edge inside it once. Edges too long to
+		// keep are neither added nor, later, removed. Chunks elsewhere are left alone: their
+		// edges were final when they were published, see kHaloRadius.
+		void applyChanges(Edit& edit) {
+			for (const auto& change : changes_) {
+				if (tooLong(change.a, change.b)) {
 					continue;
 				}
-				for (int j = 0, k = 1; j < 3; j++, k = (k + 1) % 3) {
-					// FIXME: duplicate edges
-					const auto& a = vertexKeys[dt.triangles[i + j]];
-					const auto& b = vertexKeys[dt.triangles[i + k]];
-					if (distanceSqr(Vec2f(vertexCoords[dt.triangles[i + j]], vertexCoords[dt.triangles[i + j] + 1]),
-									Vec2f(vertexCoords[dt.triangles[i + k]], vertexCoords[dt.triangles[i + k] + 1])) 
-						> kMaxEdgeLength * kMaxEdgeLength) {
-						continue;
+				const auto& a = vertexKeys_[change.a];
+				const auto& b = vertexKeys_[change.b];
+				auto apply = [&](const VertexKey& from, const VertexKey& to) {
+					auto* grid = editGrid(edit, from.g);
+					if (!grid) {
+						return;
 					}
-					if (a.g == b.g) {
-						grids_[a.g]->addEdge(EdgeKey{ a, b });
+					if (change.added) {
+						grid->addEdge(EdgeKey{ from, to });
 					}
 					else {
-						grids_[a.g]->addEdge(EdgeKey{ a, b });
-						grids_[b.g]->addEdge(EdgeKey{ b, a });
+						grid->removeEdge(EdgeKey{ from, to });
 					}
+				};
+				apply(a, b);
+				if (a.g != b.g) {
+					apply(b, a);
 				}
 			}
+		}
 
-			// Clean up edgey edges.
-			//for (auto* ng : getNeighborGrids(gx, gy, kCleanUpRadiusHeuristic)) {
-			//	if (ng) {
-			//		ng->breakFarEdges(1);
-			//	}
-			//}
+		// Chunk k as the triangulation has it: its vertices from their records, and the edges
+		// between them and to other chunks that are not too long to keep.
+		std::unique_ptr<TriangulationGrid> rebuildGrid(const GridKey& k) const {
+			const auto& range = *chunkVertices_.find(k.packed());
+			auto begin = vertexPositions_.begin() + range.first;
+			auto vertices = std::vector<Vec2f>(begin, begin + range.count);
+			auto edges = std::vector<EdgeKey>{};
+			for (int id = range.first; id < range.first + range.count; id++) {
+				triangulation_.forEachNeighbor(id, [&](int other) {
+					// an edge inside the chunk once
+					if (!tooLong(id, other) && (vertexKeys_[other].g != k || other > id)) {
+						edges.emplace_back(vertexKeys_[id], vertexKeys_[other]);
+					}
+				});
+			}
+			return std::make_unique<TriangulationGrid>(k.gridX, k.gridY, std::move(vertices), edges);
 		}
 
-		std::vector<TriangulationGrid*> getNeighborGrids(int x, int y, int r) {
-			auto result = std::vector<TriangulationGrid*>{};
-			const int r2 = (r * 2 + 1) * (r * 2 + 1);
-			if (r2 <= 100) result.reserve(r2);
-			
-			int sx = x - r;
-			int ex = x + r + 1;
-			int sy = y - r;
-			int ey = y + r + 1;
+		bool tooLong(int a, int b) const {
+			return distanceSqr(vertexPositions_[a], vertexPositions_[b]) > kMaxEdgeLength * kMaxEdgeLength;
+		}
 
-			for (int tx = sx; tx < ex; tx++) {
-				for (int ty = sy; ty < ey; ty++) {
-					if (tx == x && ty == y)
-						continue;
+		// Counts the edited chunks against the budget, evicts what is over it, and swaps the
+		// new snapshot in.
+		void commitEdit(Edit& edit) {
+			edit.grids.forEach([&](uint64_t key, TriangulationGrid* grid) {
+				auto [resident, added] = resident_.tryEmplace(key, ResidentGrid{ tick_, 0 });
+				residentBytes_ = residentBytes_ + grid->bytes() - resident->bytes;
+				resident->bytes = grid->bytes();
+			});
+
+			if (residentBytes_ > budget_) {
+				evict(edit);
+			}
 
-					auto it = grids_.find(GridKey{ tx, ty });
-					if (it != grids_.end()) {
-						result.push_back(it->second.get());
-					}
-				}
+			const auto* old = edit.old;
+			current_.store(edit.next.release());
+			EpochDomain::shared().retire([old] { delete old; });
+
+			if (spill_ && vertexKeys_.size() > std::max(kMinTrimVertices, 2 * trimmedVertices_)) {
+				trimTriangulation();
 			}
+		}
 
-			return result;
+		// Spills the least recently used chunks the edit did not touch, out of sight of the
+		// viewers, until the chunks in memory fit in kEvictTarget of the budget; going
+		// below the budget leaves room for a few publishes before the next eviction.
+		void evict(Edit& edit) {
+			auto candidates = std::vector<std::pair<uint64_t, uint64_t>>{}; // last use, key
+			resident_.forEach([&](uint64_t key, const ResidentGrid& resident) {
+				if (!edit.grids.contains(key) && !nearViewer(GridKey::unpack(key))) {
+					candidates.emplace_back(resident.lastUse, key);
+				}
+			});
+			std::sort(candidates.begin(), candidates.end());
+
+			const size_t target = static_cast<size_t>(budget_ * kEvictTarget);
+			size_t evicted = 0;
+			auto edges = std::vector<EdgeKey>{};
+			for (const auto& [lastUse, key] : candidates) {
+				if (residentBytes_ <= target) {
+					break;
+				}
+				const auto k = GridKey::unpack(key);
+				const auto* grid = edit.next->find(k.gridX, k.gridY);
+				edges.clear();
+				grid->forEachEdge([&](const EdgeKey& e) { edges.push_back(e); });
+				if (!spill_->write(k, grid->vertices(), edges)) {
+					TORA_TRACE(Info, "cannot spill grid (%d, %d), keeping it in memory", k.gridX, k.gridY);
+					break;
+				}
+				edit.next->set(k.gridX, k.gridY, nullptr, edit.copied);
+				residentBytes_ -= resident_.find(key)->bytes;
+				resident_.erase(key);
+				evicted++;
+			}
+			TORA_TRACE(Debug, "evicted %zu grids, %zu bytes resident", evicted, residentBytes_);
 		}
 
-		void render(sf::RenderWindow& window) {
-			for (const auto& [key, grid] : grids_) {
-				for (const auto& e : grid->edges()) {
-					if (e.a.g.gridY > e.b.g.gridY || e.a.g.gridY == e.b.g.gridY && e.a.g.gridX > e.b.g.gridX) {
-						// Between grids, each grid stores half-edges.
-						// Establish a consistent rule to draw only one of them.
-						continue;
+		// Rebuilds the triangulation from the chunks within kHaloRadius of one in memory,
+		// which is all the chunks in memory need, dropping the evicted ones far from any of
+		// them; they are sampled again when they or a neighbor come back. Runs once the
+		// triangulation has doubled since the last time, so the rebuilds cost a constant
+		// per vertex inserted.
+		void trimTriangulation() {
+			auto keep = FlatHashMap<uint8_t>{};
+			resident_.forEach([&](uint64_t key, const ResidentGrid&) {
+				const auto k = GridKey::unpack(key);
+				for (int ty = k.gridY - kHaloRadius; ty <= k.gridY + kHaloRadius; ty++) {
+					for (int tx = k.gridX - kHaloRadius; tx <= k.gridX + kHaloRadius; tx++) {
+						keep.tryEmplace(GridKey{ tx, ty }.packed(), 1);
 					}
-					const auto& v1 = grids_[e.a.g]->vertices()[e.a.index];
-					const auto& v2 = grids_[e.b.g]->vertices()[e.b.index];
-					sf::Vertex line[] = {
-						sf::Vertex(v1),
-						sf::Vertex(v2),
-					};
-					window.draw(line, 2, sf::Lines);
 				}
+			});
+			auto chunks = std::vector<GridKey>{};
+			size_t kept = 0;
+			keep.forEach([&](uint64_t key, uint8_t) {
+				if (const auto* range = chunkVertices_.find(key)) {
+					chunks.push_back(GridKey::unpack(key));
+					kept += range->count;
+				}
+			});
+
+			const size_t before = vertexKeys_.size();
+			if (kept > before - before / 4) {
+				// too little to drop to be worth a rebuild
+				trimmedVertices_ = before;
+				return;
 			}
+
+			// row by row, so each chunk's walk starts next to it
+			std::sort(chunks.begin(), chunks.end(), [](const GridKey& a, const GridKey& b) {
+				return a.gridY != b.gridY ? a.gridY < b.gridY : a.gridX < b.gridX;
+			});
+			auto positions = std::move(vertexPositions_);
+			auto ranges = std::move(chunkVertices_);
+			triangulation_ = geometry::IncrementalDelaunay{};
+			vertexKeys_ = std::vector<VertexKey>{};
+			vertexPositions_ = std::vector<Vec2f>{};
+			chunkVertices_ = FlatHashMap<VertexRange>{};
+			sampled_ = FlatHashMap<std::vector<Vec2f>>{};
+			vertexKeys_.reserve(kept);
+			vertexPositions_.reserve(kept);
+			for (const auto& k : chunks) {
+				const auto* range = ranges.find(k.packed());
+				insertGrid(k, std::span<const Vec2f>(positions).subspan(range->first, range->count), nullptr);
+			}
+			trimmedVertices_ = vertexKeys_.size();
+			TORA_TRACE(Debug, "triangulation trimmed from %zu to %zu vertices", before, trimmedVertices_);
 		}
 
-	private:
-		std::unordered_map<GridKey, std::unique_ptr<TriangulationGrid>> grids_;
-		Random random_;
-		static const int kVerticesPerGrid = 3;
-		static const int kPutVertexMaxRetries = 10;
+		bool nearViewer(const GridKey& k) const {
+			return std::any_of(viewers_.begin(), viewers_.end(), [&](const GridKey& v) {
+				return std::abs(v.gridX - k.gridX) <= keepRadius_ && std::abs(v.gridY - k.gridY) <= keepRadius_;
+			});
+		}
+
+		void finishGrid(int gx, int gy) {
+			std::lock_guard lock{ scheduleMutex_ };
+			requests_.erase(GridKey{ gx, gy }.packed());
+		}
+
+		// the latest snapshot; replaced, never modified, under publishMutex_
+		std::atomic<const GridSnapshot*> current_{ new GridSnapshot };
+		mutable std::mutex publishMutex_;
+
+		// the triangulation of the vertices of the chunks in memory and those around them,
+		// and per triangulation vertex its key and position; all under publishMutex_
+		geometry::IncrementalDelaunay triangulation_;
+		std::vector<VertexKey> vertexKeys_;
+		std::vector<Vec2f> vertexPositions_;
+		struct VertexRange {
+			int first;
+			int count;
+		};
+		FlatHashMap<VertexRange> chunkVertices_; // per chunk in the triangulation, its vertices' ids
+		FlatHashMap<std::vector<Vec2f>> sampled_; // chunks sampled, not yet in the triangulation
+		std::vector<geometry::IncrementalDelaunay::EdgeChange> changes_;
+		size_t trimmedVertices_ = 0; // vertices after the last trimTriangulation
+
+		// memory accounting and eviction, under publishMutex_
+		struct ResidentGrid {
+			uint64_t lastUse; // tick_ when a viewer was last near, or it was published
+			size_t bytes;
+		};
+		FlatHashMap<ResidentGrid> resident_; // per chunk in memory
+		size_t residentBytes_ = 0;
+		size_t budget_ = SIZE_MAX;
+		int keepRadius_ = 0;
+		uint64_t tick_ = 0;
+		std::vector<GridKey> viewers_;
+		std::unique_ptr<ChunkSpill> spill_;
+
+		// chunks requested and not yet published, and the first error a chunk task threw
+		mutable std::mutex scheduleMutex_;
+		FlatHashMap<uint8_t> requests_;
+		std::exception_ptr error_;
+
+		uint64_t seed_;
+		ThreadPool& pool_;
+
 		static const int kGridSize = 80;
-		static const int kMinDistanceBetweenVertices = 10;
+		static const int kMinDistanceBetweenVertices = 30;
 		static const int kMaxEdgeLength = kGridSize * 1.414;
-		static const int kMaxImpactRadiusHeuristic = 2;
-		// static const int kCleanUpRadiusHeuristic = 3;
-		static const int kArtificialHullSteps = 9;
-		static const int kArtificialHullExtension = 4;
+		static constexpr double kEvictTarget = 0.875;
+
+		// Publishing a chunk inserts the chunks this far around it into the triangulation
+		// too. An empty circle through one of its vertices that took in a vertex beyond them
+		// would hold an empty disk 160 units across inside them, a gap the sampling never
+		// leaves; so the chunk's edges are those of the triangulation of the whole, endless
+		// map, and later vertices never change them.
+		static const int kHaloRadius = TriangulationGrid::kMaxReach;
+
+		// below this many vertices the triangulation is never trimmed
+		static constexpr size_t kMinTrimVertices = 1 << 14;
+
+		// an edge shorter than kMaxReach chunks spans at most kMaxReach chunk borders
+		static_assert(kMaxEdgeLength < TriangulationGrid::kMaxReach * kGridSize);
 	};
 
 } // namespace tora::sim
@@ -0,0 +1,225 @@
+#include "IncrementalDelaunay.h"
+
+#include <cmath>
+
+#include "Predicates.h"
+
+namespace tora::geometry {
+
+IncrementalDelaunay::IncrementalDelaunay()
+{
+    // contains the square [-kBound, kBound]^2 with room to spare
+    points_ = {
+        Point(-3 * kBound, -2 * kBound),
+        Point(3 * kBound, -2 * kBound),
+        Point(0, 4 * kBound),
+    };
+    vertexEdge_.assign(kSuperVertices, -1);
+    setTriangle(addTriangle(), 0, 1, 2);
+}
+
+int IncrementalDelaunay::insert(const Point& p, std::vector<EdgeChange>* changes, int near)
+{
+    if (!(std::abs(p.x) <= kBound && std::abs(p.y) <= kBound)) {
+        return -1;
+    }
+
+    int start = near >= 0 && near < size() ? vertexEdge_[near + kSuperVertices] / 3 : lastTriangle_;
+    int onEdge = -1, duplicate = -1;
+    int t = locate(p, start, onEdge, duplicate);
+    if (t == -1) {
+        return duplicate - kSuperVertices;
+    }
+
+    const int v = static_cast<int>(points_.size());
+    points_.push_back(p);
+    vertexEdge_.push_back(-1);
+
+    thread_local std::vector<int> stack;
+    stack.clear();
+    if (onEdge == -1) {
+        splitTriangle(t, v, stack, changes);
+    }
+    else {
+        splitEdge(onEdge, v, stack, changes);
+    }
+    legalize(stack, changes);
+
+    lastTriangle_ = vertexEdge_[v] / 3;
+    return v - kSuperVertices;
+}
+
+int IncrementalDelaunay::locate(const Point& p, int start, int& onEdge, int& duplicate) const
+{
+    // Visibility walk: cross any edge that has p strictly on its far side. It terminates
+    // on Delaunay triangulations, and p is always inside the super-triangle.
+    int t = start;
+    int entered = -1;
+    while (true) {
+        int crossed = -1;
+        for (int i = 0; i < 3; i++) {
+            int e = 3 * t + i;
+            if (e == entered) {
+                continue;
+            }
+            const auto& a = points_[triangles_[e]];
+            const auto& b = points_[triangles_[next(e)]];
+            if (orient2d(a, b, p) < 0) {
+                crossed = e;
+                break;
+            }
+        }
+        if (crossed == -1) {
+            break;
+        }
+        entered = halfEdges_[crossed];
+        t = entered / 3;
+    }
+
+    onEdge = -1;
+    for (int i = 0; i < 3; i++) {
+        int e = 3 * t + i;
+        const auto& a = points_[triangles_[e]];
+        if (a.x == p.x && a.y == p.y) {
+            duplicate = triangles_[e];
+            return -1;
+        }
+        if (orient2d(a, points_[triangles_[next(e)]], p) == 0) {
+            onEdge = e;
+        }
+    }
+    return t;
+}
+
+void IncrementalDelaunay::splitTriangle(int t, int p, std::vector<int>& stack, std::vector<EdgeChange>* changes)
+{
+    const int e = 3 * t;
+    const int a = triangles_[e], b = triangles_[e + 1], c = triangles_[e + 2];
+    const int ab = halfEdges_[e], bc = halfEdges_[e + 1], ca = halfEdges_[e + 2];
+
+    const int t1 = addTriangle();
+    const int t2 = addTriangle();
+    setTriangle(t, p, a, b);
+    setTriangle(t1, p, b, c);
+    setTriangle(t2, p, c, a);
+
+    link(3 * t + 1, ab);
+    link(3 * t1 + 1, bc);
+    link(3 * t2 + 1, ca);
+    link(3 * t, 3 * t2 + 2);
+    link(3 * t + 2, 3 * t1);
+    link(3 * t1 + 2, 3 * t2);
+
+    record(changes, p, a, true);
+    record(changes, p, b, true);
+    record(changes, p, c, true);
+    stack.push_back(3 * t + 1);
+    stack.push_back(3 * t1 + 1);
+    stack.push_back(3 * t2 + 1);
+}
+
+void IncrementalDelaunay::splitEdge(int e, int p, std::vector<int>& stack, std::vector<EdgeChange>* changes)
+{
+    // e runs a -> b in triangle (a, b, c), its twin b -> a in triangle (b, a, d)
+    const int f = halfEdges_[e];
+    const int a = triangles_[e], b = triangles_[next(e)], c = triangles_[prev(e)];
+    const int d = triangles_[prev(f)];
+    const int bc = halfEdges_[next(e)], ca = halfEdges_[prev(e)];
+    const int ad = halfEdges_[next(f)], db = halfEdges_[prev(f)];
+
+    const int t0 = e / 3, t1 = addTriangle(), t2 = f / 3, t3 = addTriangle();
+    setTriangle(t0, p, b, c);
+    setTriangle(t1, p, c, a);
+    setTriangle(t2, p, a, d);
+    setTriangle(t3, p, d, b);
+
+    link(3 * t0 + 1, bc);
+    link(3 * t1 + 1, ca);
+    link(3 * t2 + 1, ad);
+    link(3 * t3 + 1, db);
+    link(3 * t0 + 2, 3 * t1);
+    link(3 * t1 + 2, 3 * t2);
+    link(3 * t2 + 2, 3 * t3);
+    link(3 * t3 + 2, 3 * t0);
+
+    record(changes, a, b, false);
+    record(changes, p, a, true);
+    record(changes, p, b, true);
+    record(changes, p, c, true);
+    record(changes, p, d, true);
+    for (int t : { t0, t1, t2, t3 }) {
+        stack.push_back(3 * t + 1);
+    }
+}
+
+void IncrementalDelaunay::legalize(std::vector<int>& stack, std::vector<EdgeChange>* changes)
+{
+    // Every half-edge on the stack is slot 1 of a triangle (p, x, y): the edge facing the
+    // new point p.
+    while (!stack.empty()) {
+        const int e = stack.back();
+        stack.pop_back();
+
+        const int f = halfEdges_[e];
+        if (f == -1) {
+            continue;
+        }
+        const int t0 = e / 3, t1 = f / 3;
+        const int p = triangles_[3 * t0], x = triangles_[e], y = triangles_[next(e)];
+        const int q = triangles_[prev(f)];
+        if (incircle(points_[p], points_[x], points_[y], points_[q]) <= 0) {
+            continue;
+        }
+
+        // flip x-y to p-q: (p, x, y) + (y, x, q) -> (p, x, q) + (p, q, y)
+        const int px = halfEdges_[3 * t0 + 0], yp = halfEdges_[3 * t0 + 2];
+        const int xq = halfEdges_[next(f)], qy = halfEdges_[prev(f)];
+        setTriangle(t0, p, x, q);
+        setTriangle(t1, p, q, y);
+        link(3 * t0 + 0, px);
+        link(3 * t0 + 1, xq);
+        link(3 * t0 + 2, 3 * t1);
+        link(3 * t1 + 1, qy);
+        link(3 * t1 + 2, yp);
+
+        record(changes, x, y, false);
+        record(changes, p, q, true);
+        stack.push_back(3 * t0 + 1);
+        stack.push_back(3 * t1 + 1);
+    }
+}
+
+int IncrementalDelaunay::addTriangle()
+{
+    const int t = static_cast<int>(triangles_.size() / 3);
+    triangles_.resize(triangles_.size() + 3, -1);
+    halfEdges_.resize(halfEdges_.size() + 3, -1);
+    return t;
+}
+
+void IncrementalDelaunay::setTriangle(int t, int a, int b, int c)
+{
+    triangles_[3 * t] = a;
+    triangles_[3 * t + 1] = b;
+    triangles_[3 * t + 2] = c;
+    vertexEdge_[a] = 3 * t;
+    vertexEdge_[b] = 3 * t + 1;
+    vertexEdge_[c] = 3 * t + 2;
+}
+
+void IncrementalDelaunay::link(int e, int twin)
+{
+    halfEdges_[e] = twin;
+    if (twin != -1) {
+        halfEdges_[twin] = e;
+    }
+}
+
+void IncrementalDelaunay::record(std::vector<EdgeChange>* changes, int a, int b, bool added) const
+{
+    if (changes && a >= kSuperVertices && b >= kSuperVertices) {
+        changes->push_back(EdgeChange{ a - kSuperVertices, b - kSuperVertices, added });
+    }
+}
+
+} // namespace tora::geometry
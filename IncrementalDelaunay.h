@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Geometry.h"
+
+namespace tora::geometry {
+
+// A Delaunay triangulation that grows one point at a time and is never rebuilt.
+//
+// A point is located by walking triangle to triangle from a triangle near a given vertex,
+// inserted by splitting the triangle (or edge) it lands in, and the Delaunay property is
+// restored with Lawson flips around it. Only triangles whose circumcircle contains the new
+// point change, so the cost of an insertion depends on the neighborhood of the point, not
+// on how many points are in the triangulation.
+//
+// Everything lives inside a super-triangle kBound a side around the origin; points further
+// out are rejected. The super-triangle's corners are not vertices as far as the interface
+// is concerned: ids, edges and changes only ever mention inserted points. All tests go
+// through the exact predicates, so the structure stays consistent on any input.
+//
+// Triangles are stored delaunator style: half-edge e runs from triangles_[e] to
+// triangles_[next(e)], triangle e / 3 is counter-clockwise (by orient2d), and
+// halfEdges_[e] is the opposite half-edge or -1.
+class IncrementalDelaunay
+{
+public:
+    static constexpr double kBound = 1e12;
+
+    // An edge that appeared or disappeared during an insertion, in the order it happened;
+    // an edge added by one insertion may be removed by a later one.
+    struct EdgeChange
+    {
+        int a;
+        int b;
+        bool added;
+    };
+
+    IncrementalDelaunay();
+
+    // Inserts p and returns its id, ids counting up from 0. If p is already a vertex, returns
+    // that vertex's id and changes nothing; if it is out of bounds, returns -1. The walk
+    // starts next to vertex near, or where the last insertion ended when near is -1.
+    // Edge changes are appended to changes when given.
+    int insert(const Point& p, std::vector<EdgeChange>* changes = nullptr, int near = -1);
+
+    int size() const { return static_cast<int>(points_.size()) - kSuperVertices; }
+    const Point& point(int id) const { return points_[id + kSuperVertices]; }
+
+    // f(a, b) once for every edge between two inserted points
+    template <class F>
+    void forEachEdge(F&& f) const
+    {
+        for (size_t e = 0; e < triangles_.size(); e++) {
+            int twin = halfEdges_[e];
+            if (twin != -1 && twin < static_cast<int>(e)) {
+                continue;
+            }
+            int a = triangles_[e], b = triangles_[next(static_cast<int>(e))];
+            if (a >= kSuperVertices && b >= kSuperVertices) {
+                f(a - kSuperVertices, b - kSuperVertices);
+            }
+        }
+    }
+
+    // f(b) for every inserted point b with an edge to point id
+    template <class F>
+    void forEachNeighbor(int id, F&& f) const
+    {
+        // every inserted point is inside the super-triangle, so the triangles around it
+        // close up; turning from an edge leaving it to the twin of the edge arriving
+        // before that one visits each
+        const int start = vertexEdge_[id + kSuperVertices];
+        int e = start;
+        do {
+            int b = triangles_[next(e)];
+            if (b >= kSuperVertices) {
+                f(b - kSuperVertices);
+            }
+            e = halfEdges_[prev(e)];
+        } while (e != start);
+    }
+
+private:
+    static constexpr int kSuperVertices = 3;
+
+    static int next(int e) { return e % 3 == 2 ? e - 2 : e + 1; }
+    static int prev(int e) { return e % 3 == 0 ? e + 2 : e - 1; }
+
+    // the triangle containing p, or -1 if p is a vertex; onEdge is the half-edge p lies on,
+    // -1 if it is strictly inside
+    int locate(const Point& p, int start, int& onEdge, int& duplicate) const;
+
+    void splitTriangle(int t, int p, std::vector<int>& stack, std::vector<EdgeChange>* changes);
+    void splitEdge(int e, int p, std::vector<int>& stack, std::vector<EdgeChange>* changes);
+    void legalize(std::vector<int>& stack, std::vector<EdgeChange>* changes);
+
+    int addTriangle();
+    void setTriangle(int t, int a, int b, int c);
+    void link(int e, int twin);
+    void record(std::vector<EdgeChange>* changes, int a, int b, bool added) const;
+
+    std::vector<Point> points_;
+    std::vector<int> triangles_;
+    std::vector<int> halfEdges_;
+    std::vector<int> vertexEdge_; // per vertex, a half-edge starting there
+    int lastTriangle_ = 0;
+};
+
+} // namespace tora::geometry
@@ -0,0 +1,111 @@
+#include "PointInPolygon.h"
+
+#if !defined(TORA_NO_SIMD) && defined(__AVX2__)
+#define TORA_PIP_AVX2 1
+#include <immintrin.h>
+#elif !defined(TORA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TORA_PIP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace tora::geometry {
+
+PreparedPolygon::PreparedPolygon(const Polygon& polygon)
+{
+    prepare(polygon.vertices, polygon.vertices.size());
+}
+
+PreparedPolygon::PreparedPolygon(PolygonView polygon)
+{
+    prepare(polygon, polygon.size());
+}
+
+template <class Vertices>
+void PreparedPolygon::prepare(const Vertices& v, size_t n)
+{
+    x_.resize(n);
+    y_.resize(n);
+    yj_.resize(n);
+    dx_.resize(n);
+    dy_.resize(n);
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        x_[i] = v[i].x;
+        y_[i] = v[i].y;
+        yj_[i] = v[j].y;
+        dx_[i] = v[j].x - v[i].x;
+        dy_[i] = v[j].y - v[i].y;
+    }
+}
+
+bool PreparedPolygon::contains(const Point& p) const
+{
+    bool inside = false;
+    for (size_t k = 0; k < x_.size(); k++) {
+        if ((y_[k] > p.y) != (yj_[k] > p.y) && p.x < dx_[k] * (p.y - y_[k]) / dy_[k] + x_[k]) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+const char* PreparedPolygon::kernelName()
+{
+#if defined(TORA_PIP_AVX2)
+    return "avx2";
+#elif defined(TORA_PIP_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void PreparedPolygon::contains(std::span<const double> xs, std::span<const double> ys, std::span<uint64_t> mask) const
+{
+    const size_t n = xs.size();
+    const size_t edges = x_.size();
+    for (size_t w = 0; w < (n + 63) / 64; w++) {
+        mask[w] = 0;
+    }
+
+    size_t i = 0;
+
+    // Lanes that do not straddle an edge may divide by zero; the straddle mask discards
+    // them, and ordered comparisons are false for NaN just as they are in scalar code.
+#if defined(TORA_PIP_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        __m256d px = _mm256_loadu_pd(xs.data() + i);
+        __m256d py = _mm256_loadu_pd(ys.data() + i);
+        __m256d inside = _mm256_setzero_pd();
+        for (size_t k = 0; k < edges; k++) {
+            __m256d yi = _mm256_broadcast_sd(&y_[k]);
+            __m256d straddle = _mm256_xor_pd(_mm256_cmp_pd(yi, py, _CMP_GT_OQ), _mm256_cmp_pd(_mm256_broadcast_sd(&yj_[k]), py, _CMP_GT_OQ));
+            __m256d t = _mm256_mul_pd(_mm256_broadcast_sd(&dx_[k]), _mm256_sub_pd(py, yi));
+            t = _mm256_add_pd(_mm256_div_pd(t, _mm256_broadcast_sd(&dy_[k])), _mm256_broadcast_sd(&x_[k]));
+            inside = _mm256_xor_pd(inside, _mm256_and_pd(straddle, _mm256_cmp_pd(px, t, _CMP_LT_OQ)));
+        }
+        mask[i / 64] |= static_cast<uint64_t>(_mm256_movemask_pd(inside)) << (i % 64);
+    }
+#elif defined(TORA_PIP_SSE2)
+    for (; i + 2 <= n; i += 2) {
+        __m128d px = _mm_loadu_pd(xs.data() + i);
+        __m128d py = _mm_loadu_pd(ys.data() + i);
+        __m128d inside = _mm_setzero_pd();
+        for (size_t k = 0; k < edges; k++) {
+            __m128d yi = _mm_set1_pd(y_[k]);
+            __m128d straddle = _mm_xor_pd(_mm_cmpgt_pd(yi, py), _mm_cmpgt_pd(_mm_set1_pd(yj_[k]), py));
+            __m128d t = _mm_mul_pd(_mm_set1_pd(dx_[k]), _mm_sub_pd(py, yi));
+            t = _mm_add_pd(_mm_div_pd(t, _mm_set1_pd(dy_[k])), _mm_set1_pd(x_[k]));
+            inside = _mm_xor_pd(inside, _mm_and_pd(straddle, _mm_cmplt_pd(px, t)));
+        }
+        mask[i / 64] |= static_cast<uint64_t>(_mm_movemask_pd(inside)) << (i % 64);
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (contains(Point(xs[i], ys[i]))) {
+            mask[i / 64] |= uint64_t{ 1 } << (i % 64);
+        }
+    }
+}
+
+} // namespace tora::geometry
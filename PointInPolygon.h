@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Geometry.h"
+#include "PolygonSet.h"
+
+namespace tora::geometry {
+
+// One polygon's edges laid out for testing many points against it at once.
+//
+// Points come in as separate x and y arrays and are tested several at a time with
+// AVX2 (4 points) or SSE2 (2 points), whichever the build targets, with a scalar loop for
+// the rest. Every lane evaluates exactly the expression Polygon::contains does, in the
+// same order, so the answers agree bit for bit; the per-edge differences are computed
+// once here instead of once per point.
+class PreparedPolygon
+{
+public:
+    explicit PreparedPolygon(const Polygon& polygon);
+    explicit PreparedPolygon(PolygonView polygon);
+
+    // Sets bit i % 64 of mask[i / 64] iff polygon.contains(Point(xs[i], ys[i])), and clears
+    // it otherwise. xs and ys have the same size, mask holds (size + 63) / 64 words.
+    void contains(std::span<const double> xs, std::span<const double> ys, std::span<uint64_t> mask) const;
+
+    bool contains(const Point& p) const;
+
+    // "avx2", "sse2" or "scalar", the kernel this build uses
+    static const char* kernelName();
+
+private:
+    template <class Vertices>
+    void prepare(const Vertices& v, size_t n);
+
+    // edge k runs from vertex k - 1 to vertex k, matching j and i in Polygon::contains
+    std::vector<double> x_;  // vertices[i].x
+    std::vector<double> y_;  // vertices[i].y
+    std::vector<double> yj_; // vertices[j].y
+    std::vector<double> dx_; // vertices[j].x - vertices[i].x
+    std::vector<double> dy_; // vertices[j].y - vertices[i].y
+};
+
+} // namespace tora::geometry
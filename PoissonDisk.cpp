@@ -0,0 +1,107 @@
+#include "PoissonDisk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace tora::sim {
+
+PoissonDiskSampler::PoissonDiskSampler(float minDistance, int attempts)
+    : minDistance_{ minDistance }, attempts_{ attempts }, cellSize_{ minDistance / std::numbers::sqrt2_v<float> }
+{
+}
+
+void PoissonDiskSampler::sample(Vec2f origin, float size, std::span<const Vec2f> fixed, Random& random,
+    std::vector<Vec2f>& out)
+{
+    const float r = minDistance_;
+    gridOrigin_ = Vec2f{ origin.x - r, origin.y - r };
+    columns_ = static_cast<int>(std::ceil((size + 2 * r) / cellSize_));
+    rows_ = columns_;
+    head_.assign(static_cast<size_t>(columns_) * rows_, -1);
+    next_.clear();
+    points_.clear();
+    active_.clear();
+
+    auto inSquare = [&](Vec2f p) {
+        return p.x >= origin.x && p.x < origin.x + size && p.y >= origin.y && p.y < origin.y + size;
+    };
+
+    for (const auto& p : fixed) {
+        if (p.x >= gridOrigin_.x && p.x < origin.x + size + r && p.y >= gridOrigin_.y && p.y < origin.y + size + r) {
+            insert(p);
+        }
+    }
+    const int fixedCount = static_cast<int>(points_.size());
+
+    // one random start, then grow from it and from the fixed points alike
+    for (int t = 0; t < attempts_; t++) {
+        auto p = Vec2f{ origin.x + random.getRandomBetween(0.0f, size), origin.y + random.getRandomBetween(0.0f, size) };
+        if (inSquare(p) && isFarFromAll(p)) {
+            insert(p);
+            break;
+        }
+    }
+    for (int i = 0; i < static_cast<int>(points_.size()); i++) {
+        active_.push_back(i);
+    }
+
+    while (!active_.empty()) {
+        const size_t slot = std::min(static_cast<size_t>(random.getRandomFloat() * active_.size()), active_.size() - 1);
+        const Vec2f center = points_[active_[slot]];
+
+        bool placed = false;
+        for (int t = 0; t < attempts_; t++) {
+            // uniform by area over the ring [r, 2r)
+            float radius = r * std::sqrt(random.getRandomBetween(1.0f, 4.0f));
+            float angle = random.getRandomBetween(0.0f, 2 * std::numbers::pi_v<float>);
+            auto p = Vec2f{ center.x + radius * std::cos(angle), center.y + radius * std::sin(angle) };
+            if (inSquare(p) && isFarFromAll(p)) {
+                insert(p);
+                active_.push_back(static_cast<int>(points_.size()) - 1);
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) {
+            active_[slot] = active_.back();
+            active_.pop_back();
+        }
+    }
+
+    out.insert(out.end(), points_.begin() + fixedCount, points_.end());
+}
+
+bool PoissonDiskSampler::isFarFromAll(Vec2f p) const
+{
+    const float r2 = minDistance_ * minDistance_;
+    const int cx = static_cast<int>((p.x - gridOrigin_.x) / cellSize_);
+    const int cy = static_cast<int>((p.y - gridOrigin_.y) / cellSize_);
+    for (int y = std::max(cy - 2, 0); y <= std::min(cy + 2, rows_ - 1); y++) {
+        for (int x = std::max(cx - 2, 0); x <= std::min(cx + 2, columns_ - 1); x++) {
+            for (int i = head_[y * columns_ + x]; i != -1; i = next_[i]) {
+                if (distanceSqr(points_[i], p) < r2) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void PoissonDiskSampler::insert(Vec2f p)
+{
+    const int cell = cellOf(p);
+    points_.push_back(p);
+    next_.push_back(head_[cell]);
+    head_[cell] = static_cast<int>(points_.size()) - 1;
+}
+
+int PoissonDiskSampler::cellOf(Vec2f p) const
+{
+    const int x = std::clamp(static_cast<int>((p.x - gridOrigin_.x) / cellSize_), 0, columns_ - 1);
+    const int y = std::clamp(static_cast<int>((p.y - gridOrigin_.y) / cellSize_), 0, rows_ - 1);
+    return y * columns_ + x;
+}
+
+} // namespace tora::sim
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Random.h"
+#include "VectorMath.h"
+
+namespace tora::sim {
+
+// Blue-noise points by Bridson's algorithm ("Fast Poisson Disk Sampling in Arbitrary
+// Dimensions").
+//
+// Every accepted point is active until attempts_ candidates from the ring between
+// minDistance and twice that around it have all been rejected. Candidates are checked
+// against a background grid of cells minDistance / sqrt(2) wide, so a check looks at
+// the 5x5 cells around the candidate instead of every point.
+//
+// Points that already exist around the square, such as the vertices of neighboring
+// chunks, go into the grid as well, so spacing holds across chunk seams.
+class PoissonDiskSampler
+{
+public:
+    explicit PoissonDiskSampler(float minDistance, int attempts = 30);
+
+    // Appends points in [origin, origin + size) on both axes to out until no more fit,
+    // each at least minDistance from the others and from the fixed points. Fixed points
+    // further than minDistance from the square are ignored.
+    void sample(Vec2f origin, float size, std::span<const Vec2f> fixed, Random& random, std::vector<Vec2f>& out);
+
+    float minDistance() const { return minDistance_; }
+
+private:
+    bool isFarFromAll(Vec2f p) const;
+    void insert(Vec2f p);
+    int cellOf(Vec2f p) const;
+
+    float minDistance_;
+    int attempts_;
+    float cellSize_;
+
+    // the background grid covers the square grown by minDistance on every side; the
+    // buffers are kept between calls
+    Vec2f gridOrigin_;
+    int columns_ = 0;
+    int rows_ = 0;
+    std::vector<int> head_;     // first point in each cell, -1 if none
+    std::vector<int> next_;     // next point in the same cell
+    std::vector<Vec2f> points_;
+    std::vector<int> active_;
+};
+
+} // namespace tora::sim
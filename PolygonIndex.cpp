@@ -0,0 +1,232 @@
+#include "PolygonIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tora::geometry {
+
+namespace {
+
+// points and rects per task in the batch queries
+constexpr size_t kQueryGrain = 1024;
+
+// Liang-Barsky: clips the segment to r and checks that something is left
+bool segmentHitsRect(const Point& a, const Point& b, const Rect& r)
+{
+    double t0 = 0, t1 = 1;
+    auto clip = [&](double p, double q) {
+        if (p == 0) {
+            return q >= 0;
+        }
+        double t = q / p;
+        if (p < 0) {
+            if (t > t1) return false;
+            t0 = std::max(t0, t);
+        }
+        else {
+            if (t < t0) return false;
+            t1 = std::min(t1, t);
+        }
+        return true;
+    };
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    return clip(-dx, a.x - r.min.x) && clip(dx, r.max.x - a.x) && clip(-dy, a.y - r.min.y) && clip(dy, r.max.y - a.y);
+}
+
+bool overlaps(const Rect& a, const Rect& b)
+{
+    return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+bool intersects(PolygonView polygon, const Rect& r)
+{
+    for (int i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        if (segmentHitsRect(polygon[j], polygon[i], r)) {
+            return true;
+        }
+    }
+    // no edge reaches r, so it is either inside the polygon as a whole or outside
+    return polygon.contains(r.min);
+}
+
+} // namespace
+
+PolygonIndex::PolygonIndex(std::span<const Polygon> polygons)
+    : PolygonIndex([&] {
+          PolygonSet set;
+          for (const auto& polygon : polygons) {
+              set.append(polygon);
+          }
+          return set;
+      }())
+{
+}
+
+PolygonIndex::PolygonIndex(PolygonSet polygons) : polygons_{ std::move(polygons) }
+{
+    const int n = polygons_.size();
+    boxes_.resize(n);
+
+    bool first = true;
+    double totalSize = 0;
+    int numBoxes = 0;
+    for (int k = 0; k < n; k++) {
+        auto v = polygons_[k];
+        if (v.empty()) {
+            // collapsed polygons contain nothing, give them a box that overlaps nothing
+            boxes_[k] = Rect{ Point(INFINITY, INFINITY), Point(-INFINITY, -INFINITY) };
+            continue;
+        }
+        Rect box{ v[0], v[0] };
+        for (int i = 0; i < v.size(); i++) {
+            auto p = v[i];
+            box.min = Point(std::min(box.min.x, p.x), std::min(box.min.y, p.y));
+            box.max = Point(std::max(box.max.x, p.x), std::max(box.max.y, p.y));
+        }
+        boxes_[k] = box;
+        bounds_ = first ? box : Rect{ Point(std::min(bounds_.min.x, box.min.x), std::min(bounds_.min.y, box.min.y)),
+                                      Point(std::max(bounds_.max.x, box.max.x), std::max(bounds_.max.y, box.max.y)) };
+        first = false;
+        totalSize += std::max(box.max.x - box.min.x, box.max.y - box.min.y);
+        numBoxes++;
+    }
+    if (numBoxes == 0) {
+        return;
+    }
+
+    // about one cell per polygon, but no smaller than a typical polygon
+    double width = bounds_.max.x - bounds_.min.x;
+    double height = bounds_.max.y - bounds_.min.y;
+    cellSize_ = std::max(std::sqrt(width * height / numBoxes), totalSize / numBoxes);
+    if (!(cellSize_ > 0)) {
+        cellSize_ = 1;
+    }
+    cols_ = std::min(numBoxes, static_cast<int>(width / cellSize_) + 1);
+    rows_ = std::min(numBoxes, static_cast<int>(height / cellSize_) + 1);
+
+    cellStart_.assign(cols_ * rows_ + 1, 0);
+    for (int k = 0; k < n; k++) {
+        if (polygons_[k].empty()) {
+            continue;
+        }
+        const auto& box = boxes_[k];
+        for (int r = row(box.min.y); r <= row(box.max.y); r++) {
+            for (int c = col(box.min.x); c <= col(box.max.x); c++) {
+                cellStart_[r * cols_ + c + 1]++;
+            }
+        }
+    }
+    for (size_t c = 1; c < cellStart_.size(); c++) {
+        cellStart_[c] += cellStart_[c - 1];
+    }
+    cellPolygons_.resize(cellStart_.back());
+    auto fill = cellStart_;
+    for (int k = 0; k < n; k++) {
+        if (polygons_[k].empty()) {
+            continue;
+        }
+        const auto& box = boxes_[k];
+        for (int r = row(box.min.y); r <= row(box.max.y); r++) {
+            for (int c = col(box.min.x); c <= col(box.max.x); c++) {
+                cellPolygons_[fill[r * cols_ + c]++] = k;
+            }
+        }
+    }
+}
+
+int PolygonIndex::col(double x) const
+{
+    return std::clamp(static_cast<int>((x - bounds_.min.x) / cellSize_), 0, cols_ - 1);
+}
+
+int PolygonIndex::row(double y) const
+{
+    return std::clamp(static_cast<int>((y - bounds_.min.y) / cellSize_), 0, rows_ - 1);
+}
+
+int PolygonIndex::find(const Point& p) const
+{
+    if (cols_ == 0 || !overlaps(Rect{ p, p }, bounds_)) {
+        return -1;
+    }
+
+    int cell = row(p.y) * cols_ + col(p.x);
+    for (int k = cellStart_[cell]; k < cellStart_[cell + 1]; k++) {
+        int i = cellPolygons_[k];
+        if (overlaps(Rect{ p, p }, boxes_[i]) && polygons_[i].contains(p)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void PolygonIndex::query(const Rect& r, std::vector<int>& out) const
+{
+    if (cols_ == 0 || !overlaps(r, bounds_)) {
+        return;
+    }
+
+    // a polygon binned in several cells is only reported from the first one it shares
+    // with r, so nothing is reported twice
+    const size_t begin = out.size();
+    const int c0 = col(r.min.x), c1 = col(r.max.x);
+    const int r0 = row(r.min.y), r1 = row(r.max.y);
+    for (int y = r0; y <= r1; y++) {
+        for (int x = c0; x <= c1; x++) {
+            int cell = y * cols_ + x;
+            for (int k = cellStart_[cell]; k < cellStart_[cell + 1]; k++) {
+                int i = cellPolygons_[k];
+                const auto& box = boxes_[i];
+                if (std::max(col(box.min.x), c0) != x || std::max(row(box.min.y), r0) != y) {
+                    continue;
+                }
+                if (overlaps(r, box) && intersects(polygons_[i], r)) {
+                    out.push_back(i);
+                }
+            }
+        }
+    }
+    std::sort(out.begin() + begin, out.end());
+}
+
+void PolygonIndex::find(std::span<const Point> points, std::span<int> out, ThreadPool& pool) const
+{
+    pool.parallelFor(points.size(), kQueryGrain, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            out[i] = find(points[i]);
+        }
+    });
+}
+
+void PolygonIndex::query(std::span<const Rect> rects, std::vector<int>& offsets, std::vector<int>& ids, ThreadPool& pool) const
+{
+    // same scheme as offsetBatch: chunks fixed by index collect their ids, counts go into
+    // offsets, and a prefix sum places every chunk
+    const size_t n = rects.size();
+    const size_t chunks = (n + kQueryGrain - 1) / kQueryGrain;
+    std::vector<std::vector<int>> chunkIds(chunks);
+    offsets.assign(n + 1, 0);
+
+    pool.parallelFor(n, kQueryGrain, [&](size_t first, size_t last) {
+        auto& found = chunkIds[first / kQueryGrain];
+        for (size_t i = first; i < last; i++) {
+            size_t before = found.size();
+            query(rects[i], found);
+            offsets[i + 1] = static_cast<int>(found.size() - before);
+        }
+    });
+
+    for (size_t i = 0; i < n; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    ids.resize(offsets[n]);
+
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            std::copy(chunkIds[c].begin(), chunkIds[c].end(), ids.begin() + offsets[c * kQueryGrain]);
+        }
+    });
+}
+
+} // namespace tora::geometry
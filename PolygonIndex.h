@@ -0,0 +1,60 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Geometry.h"
+#include "PolygonSet.h"
+#include "ThreadPool.h"
+
+namespace tora::geometry {
+
+// Uniform grid over the bounding boxes of a set of polygons.
+//
+// Each polygon is binned into every cell its bounding box covers, at about one cell per
+// polygon and no smaller than a typical polygon, so a query only looks at the handful of
+// polygons binned where it lands. Bins are stored end to end (CSR), polygons in each bin
+// in ascending index order.
+class PolygonIndex
+{
+public:
+    PolygonIndex() = default;
+    explicit PolygonIndex(PolygonSet polygons);
+    explicit PolygonIndex(std::span<const Polygon> polygons);
+
+    const PolygonSet& polygons() const { return polygons_; }
+    PolygonView polygon(int i) const { return polygons_[i]; }
+    int size() const { return polygons_.size(); }
+
+    // Index of the polygon that contains p by Polygon::contains, -1 if none does.
+    // If polygons overlap, the lowest index wins.
+    int find(const Point& p) const;
+
+    // Appends the indices of the polygons that intersect r to out, ascending: polygons
+    // with a point inside r, or with r inside them.
+    void query(const Rect& r, std::vector<int>& out) const;
+
+    // find() for every point, on the pool. out must hold points.size() entries.
+    void find(std::span<const Point> points, std::span<int> out, ThreadPool& pool = ThreadPool::shared()) const;
+
+    // query() for every rect, on the pool. The polygons intersecting rects[i] end up in
+    // ids[offsets[i], offsets[i + 1]), independently of the number of threads.
+    void query(std::span<const Rect> rects, std::vector<int>& offsets, std::vector<int>& ids,
+        ThreadPool& pool = ThreadPool::shared()) const;
+
+private:
+    int col(double x) const;
+    int row(double y) const;
+
+    PolygonSet polygons_;
+    std::vector<Rect> boxes_;
+
+    Rect bounds_{};
+    double cellSize_ = 1;
+    int cols_ = 0;
+    int rows_ = 0;
+    std::vector<int> cellStart_;
+    std::vector<int> cellPolygons_;
+};
+
+} // namespace tora::geometry
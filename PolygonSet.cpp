@@ -0,0 +1,173 @@
+#include "PolygonSet.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tora::geometry {
+
+bool PolygonView::contains(const Point& p) const
+{
+    bool inside = false;
+    for (int i = 0, j = size_ - 1; i < size_; j = i++) {
+        if ((y_[i] > p.y) != (y_[j] > p.y) &&
+            p.x < (x_[j] - x_[i]) * (p.y - y_[i]) / (y_[j] - y_[i]) + x_[i]) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+Polygon PolygonView::toPolygon() const
+{
+    Polygon polygon;
+    polygon.vertices.reserve(size_);
+    for (int i = 0; i < size_; i++) {
+        polygon.vertices.push_back(Point(x_[i], y_[i]));
+    }
+    return polygon;
+}
+
+void PolygonSet::reserve(int polygons, int vertices)
+{
+    offsets_.reserve(polygons + 1);
+    x_.reserve(vertices);
+    y_.reserve(vertices);
+}
+
+void PolygonSet::clear()
+{
+    x_.clear();
+    y_.clear();
+    offsets_.assign(1, 0);
+}
+
+void PolygonSet::append(std::span<const Point> vertices)
+{
+    for (const auto& p : vertices) {
+        x_.push_back(p.x);
+        y_.push_back(p.y);
+    }
+    offsets_.push_back(static_cast<int>(x_.size()));
+}
+
+void PolygonSet::append(PolygonView polygon)
+{
+    x_.insert(x_.end(), polygon.xs().begin(), polygon.xs().end());
+    y_.insert(y_.end(), polygon.ys().begin(), polygon.ys().end());
+    offsets_.push_back(static_cast<int>(x_.size()));
+}
+
+void PolygonSet::resize(std::span<const int> vertexCounts)
+{
+    offsets_.resize(vertexCounts.size() + 1);
+    offsets_[0] = 0;
+    for (size_t i = 0; i < vertexCounts.size(); i++) {
+        offsets_[i + 1] = offsets_[i] + vertexCounts[i];
+    }
+    x_.assign(offsets_.back(), 0.0);
+    y_.assign(offsets_.back(), 0.0);
+}
+
+int windingDirection(PolygonView polygon)
+{
+    double sum = 0;
+    for (int i = 0; i < polygon.size(); i++) {
+        auto p1 = polygon[i];
+        auto p2 = polygon[(i + 1) % polygon.size()];
+        sum += (p1.x * p2.y - p2.x * p1.y);
+    }
+    return sum > 0 ? 1 : -1;
+}
+
+// The rest go through an array-of-structures copy kept per thread; they are linear at
+// best, so the copy does not change what they cost.
+
+namespace {
+
+const Polygon& scratchCopy(PolygonView polygon)
+{
+    thread_local Polygon scratch;
+    scratch.vertices.resize(polygon.size());
+    for (int i = 0; i < polygon.size(); i++) {
+        scratch.vertices[i] = polygon[i];
+    }
+    return scratch;
+}
+
+} // namespace
+
+bool isConvex(PolygonView polygon)
+{
+    return isConvex(scratchCopy(polygon));
+}
+
+Polygon offset(PolygonView polygon, double amount)
+{
+    return offset(scratchCopy(polygon), amount);
+}
+
+void offsetConvex(PolygonView polygon, double amount, Polygon& out)
+{
+    offsetConvex(scratchCopy(polygon), amount, out);
+}
+
+namespace {
+
+// polygons per task; also the unit results are collected in before they are stitched
+constexpr size_t kOffsetBatchGrain = 64;
+
+// Each chunk of polygons collects its vertices on its own and records the counts, which
+// then lay out the output. Chunks are fixed by index, so where a polygon lands does not
+// depend on which thread did it.
+template <class Input>
+void offsetAll(size_t n, const Input& input, std::span<const double> amounts, PolygonSet& out, ThreadPool& pool)
+{
+    if (amounts.size() != 1 && amounts.size() != n) {
+        throw std::invalid_argument{ "offsetBatch: need one amount, or one per polygon" };
+    }
+
+    const size_t chunks = (n + kOffsetBatchGrain - 1) / kOffsetBatchGrain;
+    std::vector<std::vector<Point>> chunkVertices(chunks);
+    std::vector<int> counts(n);
+
+    pool.parallelFor(n, kOffsetBatchGrain, [&](size_t first, size_t last) {
+        thread_local Polygon scratch;
+        auto& vertices = chunkVertices[first / kOffsetBatchGrain];
+        for (size_t i = first; i < last; i++) {
+            const Polygon& polygon = input(i);
+            double amount = amounts.size() == 1 ? amounts[0] : amounts[i];
+            if (isConvex(polygon)) {
+                offsetConvex(polygon, amount, scratch);
+            }
+            else {
+                scratch = offset(polygon, amount);
+            }
+            vertices.insert(vertices.end(), scratch.vertices.begin(), scratch.vertices.end());
+            counts[i] = static_cast<int>(scratch.vertices.size());
+        }
+    });
+
+    out.resize(counts);
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            int k = out.offsets()[c * kOffsetBatchGrain];
+            for (const auto& p : chunkVertices[c]) {
+                out.setVertex(k++, p);
+            }
+        }
+    });
+}
+
+} // namespace
+
+void offsetBatch(std::span<const Polygon> polygons, std::span<const double> amounts, PolygonSet& out, ThreadPool& pool)
+{
+    offsetAll(polygons.size(), [&](size_t i) -> const Polygon& { return polygons[i]; }, amounts, out, pool);
+}
+
+void offsetBatch(const PolygonSet& polygons, std::span<const double> amounts, PolygonSet& out, ThreadPool& pool)
+{
+    offsetAll(polygons.size(), [&](size_t i) -> const Polygon& { return scratchCopy(polygons[static_cast<int>(i)]); }, amounts, out, pool);
+}
+
+} // namespace tora::geometry
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Geometry.h"
+#include "ThreadPool.h"
+
+namespace tora::geometry {
+
+// One polygon inside a PolygonSet. Cheap to copy; valid until the set changes.
+class PolygonView
+{
+public:
+    PolygonView(const double* x, const double* y, int size) : x_{ x }, y_{ y }, size_{ size } {}
+
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Point operator[](int i) const { return Point(x_[i], y_[i]); }
+
+    std::span<const double> xs() const { return { x_, static_cast<size_t>(size_) }; }
+    std::span<const double> ys() const { return { y_, static_cast<size_t>(size_) }; }
+
+    // same test, and same answers, as Polygon::contains
+    bool contains(const Point& p) const;
+
+    Polygon toPolygon() const;
+
+private:
+    const double* x_;
+    const double* y_;
+    int size_;
+};
+
+// Many polygons in one structure of arrays: the x and y coordinates of all vertices are
+// stored contiguously, and polygon i is vertices [offsets[i], offsets[i + 1]).
+// A whole map of cells is three allocations, and can be handed to a renderer or
+// serializer as is.
+class PolygonSet
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const PolygonSet* set, int i) : set_{ set }, i_{ i } {}
+        PolygonView operator*() const { return (*set_)[i_]; }
+        Iterator& operator++() { i_++; return *this; }
+        bool operator==(const Iterator& other) const { return i_ == other.i_; }
+        bool operator!=(const Iterator& other) const { return i_ != other.i_; }
+
+    private:
+        const PolygonSet* set_;
+        int i_;
+    };
+
+    PolygonSet() = default;
+
+    int size() const { return static_cast<int>(offsets_.size()) - 1; }
+    bool empty() const { return size() == 0; }
+    int vertexCount() const { return offsets_.back(); }
+
+    PolygonView operator[](int i) const
+    {
+        return PolygonView(x_.data() + offsets_[i], y_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size()); }
+
+    const std::vector<double>& xs() const { return x_; }
+    const std::vector<double>& ys() const { return y_; }
+    const std::vector<int>& offsets() const { return offsets_; }
+
+    void reserve(int polygons, int vertices);
+    void clear();
+
+    void append(std::span<const Point> vertices);
+    void append(const Polygon& polygon) { append(polygon.vertices); }
+    void append(PolygonView polygon);
+
+    // Replaces the contents with polygons of the given vertex counts, to be filled in
+    // place with setVertex. Vertex k of polygon i is at offsets()[i] + k.
+    void resize(std::span<const int> vertexCounts);
+    void setVertex(int index, const Point& p)
+    {
+        x_[index] = p.x;
+        y_[index] = p.y;
+    }
+
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<int> offsets_{ 0 };
+};
+
+int windingDirection(PolygonView polygon);
+bool isConvex(PolygonView polygon);
+Polygon offset(PolygonView polygon, double amount);
+void offsetConvex(PolygonView polygon, double amount, Polygon& out);
+
+// offset() over many polygons on a thread pool. amounts holds one amount per polygon, or
+// a single amount for all of them; any other count throws std::invalid_argument. Results
+// are written to out in input order and do not depend on the number of threads; polygons
+// that collapse come out empty.
+void offsetBatch(std::span<const Polygon> polygons, std::span<const double> amounts, PolygonSet& out,
+    ThreadPool& pool = ThreadPool::shared());
+void offsetBatch(const PolygonSet& polygons, std::span<const double> amounts, PolygonSet& out,
+    ThreadPool& pool = ThreadPool::shared());
+
+} // namespace tora::geometry
@@ -0,0 +1,231 @@
+#include "Predicates.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tora::geometry {
+
+namespace {
+
+// Half an ulp of 1, the relative rounding error of one operation.
+constexpr double kEpsilon = 0x1p-53;
+
+// Bounds on the error of the floating-point determinants, relative to the sum of the
+// magnitudes of their terms. The differences of the inputs are covered too.
+constexpr double kOrientErrorBound = (3.0 + 16.0 * kEpsilon) * kEpsilon;
+constexpr double kIncircleErrorBound = (10.0 + 96.0 * kEpsilon) * kEpsilon;
+
+// An expansion is a sum of doubles that do not overlap, ordered by increasing magnitude,
+// that represents a value exactly. Its sign is the sign of its last component. Zero
+// components are dropped as they appear, which keeps the expansions of well-behaved
+// inputs (small integers, lattices) down to a component or two.
+// Capacities are worst-case bounds known at compile time, so everything is on the stack.
+template <int N>
+struct Expansion
+{
+    int size = 0;
+    double c[N];
+
+    double estimate() const { return c[size - 1]; }
+};
+
+constexpr double kSplitter = 134217729.0; // 2^27 + 1
+
+// a + b = x + y exactly, x being the rounded sum
+inline void twoSum(double a, double b, double& x, double& y)
+{
+    x = a + b;
+    double bVirtual = x - a;
+    double aVirtual = x - bVirtual;
+    y = (a - aVirtual) + (b - bVirtual);
+}
+
+// same, for |a| >= |b|
+inline void fastTwoSum(double a, double b, double& x, double& y)
+{
+    x = a + b;
+    y = b - (x - a);
+}
+
+// a * b = x + y exactly, splitting both into 26-bit halves (Dekker)
+inline void twoProduct(double a, double b, double& x, double& y)
+{
+    x = a * b;
+    double c = kSplitter * a;
+    double aHi = c - (c - a);
+    double aLo = a - aHi;
+    c = kSplitter * b;
+    double bHi = c - (c - b);
+    double bLo = b - bHi;
+    double err = x - aHi * bHi - aLo * bHi - aHi * bLo;
+    y = aLo * bLo - err;
+}
+
+inline void push(double* h, int& size, double value)
+{
+    if (value != 0) {
+        h[size++] = value;
+    }
+}
+
+template <int N>
+void finish(Expansion<N>& h, double q)
+{
+    if (q != 0 || h.size == 0) {
+        h.c[h.size++] = q;
+    }
+}
+
+Expansion<2> difference(double a, double b)
+{
+    Expansion<2> h;
+    double x, y;
+    twoSum(a, -b, x, y);
+    push(h.c, h.size, y);
+    finish(h, x);
+    return h;
+}
+
+Expansion<2> product(double a, double b)
+{
+    Expansion<2> h;
+    double x, y;
+    twoProduct(a, b, x, y);
+    push(h.c, h.size, y);
+    finish(h, x);
+    return h;
+}
+
+template <int N>
+Expansion<N> negate(Expansion<N> e)
+{
+    for (int i = 0; i < e.size; i++) {
+        e.c[i] = -e.c[i];
+    }
+    return e;
+}
+
+// merges the components of both by magnitude and sums them up in that order
+template <int A, int B>
+Expansion<A + B> sum(const Expansion<A>& e, const Expansion<B>& f)
+{
+    Expansion<A + B> h;
+    int i = 0, j = 0;
+    auto smaller = [&] {
+        if (j == f.size || (i < e.size && std::abs(e.c[i]) < std::abs(f.c[j]))) {
+            return e.c[i++];
+        }
+        return f.c[j++];
+    };
+
+    double q = smaller();
+    while (i < e.size || j < f.size) {
+        double x, y;
+        twoSum(q, smaller(), x, y);
+        push(h.c, h.size, y);
+        q = x;
+    }
+    finish(h, q);
+    return h;
+}
+
+template <int A>
+Expansion<2 * A> scale(const Expansion<A>& e, double b)
+{
+    Expansion<2 * A> h;
+    double q, y;
+    twoProduct(e.c[0], b, q, y);
+    push(h.c, h.size, y);
+    for (int i = 1; i < e.size; i++) {
+        double hi, lo, s;
+        twoProduct(e.c[i], b, hi, lo);
+        twoSum(q, lo, s, y);
+        push(h.c, h.size, y);
+        fastTwoSum(hi, s, q, y);
+        push(h.c, h.size, y);
+    }
+    finish(h, q);
+    return h;
+}
+
+template <int A, int B>
+Expansion<2 * A * B> product(const Expansion<A>& e, const Expansion<B>& f)
+{
+    Expansion<2 * A * B> h;
+    h.c[0] = 0;
+    h.size = 1;
+    for (int j = 0; j < f.size; j++) {
+        auto term = scale(e, f.c[j]);
+        auto next = sum(h, term);
+        h.size = next.size;
+        std::copy(next.c, next.c + next.size, h.c);
+    }
+    return h;
+}
+
+double orient2dExact(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    // (a - c) x (b - c) expanded over the raw coordinates, six exact products
+    auto left = sum(sum(product(ax, by), product(bx, cy)), product(cx, ay));
+    auto right = sum(sum(product(ax, cy), product(bx, ay)), product(cx, by));
+    return sum(left, negate(right)).estimate();
+}
+
+double incircleExact(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy)
+{
+    auto adx = difference(ax, dx), ady = difference(ay, dy);
+    auto bdx = difference(bx, dx), bdy = difference(by, dy);
+    auto cdx = difference(cx, dx), cdy = difference(cy, dy);
+
+    auto alift = sum(product(adx, adx), product(ady, ady));
+    auto blift = sum(product(bdx, bdx), product(bdy, bdy));
+    auto clift = sum(product(cdx, cdx), product(cdy, cdy));
+
+    auto bc = sum(product(bdx, cdy), negate(product(cdx, bdy)));
+    auto ca = sum(product(cdx, ady), negate(product(adx, cdy)));
+    auto ab = sum(product(adx, bdy), negate(product(bdx, ady)));
+
+    return sum(sum(product(alift, bc), product(blift, ca)), product(clift, ab)).estimate();
+}
+
+} // namespace
+
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    double left = (ax - cx) * (by - cy);
+    double right = (ay - cy) * (bx - cx);
+    double det = left - right;
+
+    double magnitude = std::abs(left) + std::abs(right);
+    if (std::abs(det) > kOrientErrorBound * magnitude) {
+        return det;
+    }
+    return orient2dExact(ax, ay, bx, by, cx, cy);
+}
+
+double incircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy)
+{
+    double adx = ax - dx, ady = ay - dy;
+    double bdx = bx - dx, bdy = by - dy;
+    double cdx = cx - dx, cdy = cy - dy;
+
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+
+    double magnitude = (std::abs(bdxcdy) + std::abs(cdxbdy)) * alift
+        + (std::abs(cdxady) + std::abs(adxcdy)) * blift
+        + (std::abs(adxbdy) + std::abs(bdxady)) * clift;
+    if (std::abs(det) > kIncircleErrorBound * magnitude) {
+        return det;
+    }
+    return incircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+} // namespace tora::geometry
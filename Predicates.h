@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Geometry.h"
+
+// Robust geometric predicates.
+//
+// Each predicate first evaluates its determinant in plain doubles together with a bound
+// on the rounding error (Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast
+// Robust Geometric Predicates"). Only when the result is within that bound of zero is it
+// recomputed exactly with floating-point expansions, so the sign is always right and the
+// common case costs a few extra comparisons.
+//
+// Signs follow the usual math convention with y up. In screen coordinates (y down),
+// "counter-clockwise" below is clockwise on screen.
+
+namespace tora::geometry {
+
+// > 0 if a, b, c turn counter-clockwise, < 0 if clockwise, 0 if collinear.
+// Equals cross(b - a, c - a) up to rounding.
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy);
+
+// > 0 if d lies inside the circle through a, b, c (given counter-clockwise), < 0 if
+// outside, 0 if the four points are co-circular. The sign flips for clockwise a, b, c.
+double incircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy);
+
+inline double orient2d(const Point& a, const Point& b, const Point& c)
+{
+    return orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+inline double incircle(const Point& a, const Point& b, const Point& c, const Point& d)
+{
+    return incircle(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+}
+
+} // namespace tora::geometry
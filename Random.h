@@ -1,31 +1,160 @@
 #pragma once
 
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <random>
+#include <span>
 
 namespace tora {
+    // xoshiro256++ (Blackman & Vigna): 256 bits of state, a handful of shifts and adds per
+    // number, and a jump function for carving out independent streams.
+    //
+    // The same seed gives the same numbers on every platform. For parallel work, give each
+    // thread or chunk its own generator from split() rather than sharing one.
+    //
+    // Meets UniformRandomBitGenerator, so the <random> distributions accept it too.
     class Random {
     public:
+        using result_type = uint64_t;
+
+        // seeded from std::random_device, different on every run
         Random()
-            : mt(rd()), distFloat(0.0f, 1.0f), distDouble(0.0, 1.0) {}
+            : Random(seedFromDevice()) {}
+
+        explicit Random(uint64_t seed) {
+            // splitmix64 spreads the seed over the whole state, which is never all zero
+            for (auto& word : s_) {
+                seed += 0x9e3779b97f4a7c15ull;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                word = z ^ (z >> 31);
+            }
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
 
+        result_type operator()() {
+            return next(s_[0], s_[1], s_[2], s_[3]);
+        }
+
+        // [0, 1)
         float getRandomFloat() {
-            return distFloat(mt);
+            return toUnit<float>((*this)());
         }
 
+        // [0, 1)
         double getRandomDouble() {
-            return distDouble(mt);
+            return toUnit<double>((*this)());
         }
 
+        // [min, max)
         template<typename T>
         T getRandomBetween(T min, T max) {
-            std::uniform_real_distribution<T> dist(min, max);
-            return dist(mt);
+            return min + (max - min) * toUnit<T>((*this)());
+        }
+
+        // Advances the state by 2^128 numbers.
+        void jump() {
+            static constexpr uint64_t kJump[] = {
+                0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+            };
+            uint64_t s[4] = {};
+            for (uint64_t word : kJump) {
+                for (int b = 0; b < 64; b++) {
+                    if (word & (uint64_t{ 1 } << b)) {
+                        for (int k = 0; k < 4; k++) {
+                            s[k] ^= s_[k];
+                        }
+                    }
+                    (*this)();
+                }
+            }
+            for (int k = 0; k < 4; k++) {
+                s_[k] = s[k];
+            }
+        }
+
+        // Returns a generator for the next 2^128 numbers of this stream and moves this one
+        // past them, so repeated splits hand out streams that never overlap.
+        Random split() {
+            Random child = *this;
+            jump();
+            return child;
+        }
+
+        // Fill out with uniform numbers in [0, 1) or [min, max).
+        //
+        // The numbers come from kLanes interleaved xoshiro256++ streams seeded from this
+        // generator, laid out so the loop vectorizes; they are as reproducible as the rest
+        // but differ from what calling getRandomBetween out.size() times would give.
+        void fill(std::span<float> out, float min = 0.0f, float max = 1.0f) {
+            fillBetween(out, min, max);
+        }
+
+        void fill(std::span<double> out, double min = 0.0, double max = 1.0) {
+            fillBetween(out, min, max);
         }
 
     private:
-        std::random_device rd;
-        std::mt19937 mt;
-        std::uniform_real_distribution<float> distFloat;
-        std::uniform_real_distribution<double> distDouble;
+        static constexpr int kLanes = 4;
+
+        static uint64_t next(uint64_t& s0, uint64_t& s1, uint64_t& s2, uint64_t& s3) {
+            const uint64_t result = std::rotl(s0 + s3, 23) + s0;
+            const uint64_t t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = std::rotl(s3, 45);
+            return result;
+        }
+
+        // Top bits as the mantissa of a number in [1, 2), minus one. Plain integer ops, so
+        // it vectorizes where a uint64 to double conversion would not.
+        template<typename T>
+        static T toUnit(uint64_t x) {
+            if constexpr (sizeof(T) == sizeof(float)) {
+                return std::bit_cast<float>(static_cast<uint32_t>(x >> 41) | 0x3f800000u) - 1.0f;
+            }
+            else {
+                return std::bit_cast<double>((x >> 12) | 0x3ff0000000000000ull) - 1.0;
+            }
+        }
+
+        template<typename T>
+        void fillBetween(std::span<T> out, T min, T max) {
+            const T range = max - min;
+            uint64_t s0[kLanes], s1[kLanes], s2[kLanes], s3[kLanes];
+            for (int k = 0; k < kLanes; k++) {
+                Random lane((*this)());
+                s0[k] = lane.s_[0];
+                s1[k] = lane.s_[1];
+                s2[k] = lane.s_[2];
+                s3[k] = lane.s_[3];
+            }
+
+            const size_t n = out.size();
+            size_t i = 0;
+            for (; i + kLanes <= n; i += kLanes) {
+                for (int k = 0; k < kLanes; k++) {
+                    out[i + k] = min + range * toUnit<T>(next(s0[k], s1[k], s2[k], s3[k]));
+                }
+            }
+            for (int k = 0; i < n; i++, k++) {
+                out[i] = min + range * toUnit<T>(next(s0[k], s1[k], s2[k], s3[k]));
+            }
+        }
+
+        static uint64_t seedFromDevice() {
+            std::random_device rd;
+            return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+        }
+
+        uint64_t s_[4];
     };
-} // namespace tora
\ No newline at end of file
+} // namespace tora
@@ -1,12 +1,54 @@
 #include "Sweeping.h"
+#include "Predicates.h"
+#include "Trace.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <fstream>
 
 namespace tora::sim::fortune {
 
+namespace {
+
+// Cyrus-Beck: where the line base + t * d leaves a convex polygon with positive winding.
+// With ray set only t >= 0 counts. Returns false if the line or ray misses the polygon.
+bool exitPoint(const Polygon& convex, Point base, Point d, bool ray, Point& out)
+{
+    double tEnter = ray ? 0.0 : -std::numeric_limits<double>::infinity();
+    double tExit = std::numeric_limits<double>::infinity();
+
+    const auto& v = convex.vertices;
+    for (size_t i = 0; i < v.size(); i++) {
+        auto e = v[(i + 1) % v.size()] - v[i];
+        // inside where num + t * den >= 0
+        double num = cross(e, base - v[i]);
+        double den = cross(e, d);
+        if (den == 0) {
+            if (num < 0) {
+                return false;
+            }
+        }
+        else if (den > 0) {
+            tEnter = std::max(tEnter, -num / den);
+        }
+        else {
+            tExit = std::min(tExit, -num / den);
+        }
+    }
+
+    if (tEnter > tExit || std::isinf(tExit)) {
+        return false;
+    }
+    out = base + d * tExit;
+    return true;
+}
+
+} // namespace
+
 std::ostream& operator<<(std::ostream& os, const ArcRef& ar) {
-    os << ar->id << "(" << std::prev(ar)->site << "," << ar->site << "," << std::next(ar)->site << ")";
+    os << ar->id << "(" << (ar->prev ? ar->prev->site : -1) << "," << ar->site << "," << (ar->next ? ar->next->site : -1) << ")";
     return os;
 }
 
@@ -14,49 +56,41 @@ bool State::checkVertexEvent(ArcRef arc, double sweepLineY)
 {
     clearVertexEvent(arc);
 
-    if (arc == beachline.begin() || std::next(arc) == beachline.end()) {
+    if (!arc->prev || !arc->next) {
         return false;
     }
 
-    auto prev = std::prev(arc);
-    auto next = std::next(arc);
+    auto prev = arc->prev;
+    auto next = arc->next;
 
     if (prev->site == next->site) {
         return false;
     }
 
-    auto cc = circumcircle(prev->location, arc->location, next->location);
-    auto lp = lowestPoint(cc);
-
-    if (lp.y < sweepLineY) {
+    // only converging breakpoints meet; diverging ones would collapse a growing arc
+    // and leave the breakpoints out of x order
+    if (geometry::orient2d(prev->location, arc->location, next->location) <= 0) {
         return false;
     }
 
-    std::cout << "adding vertex event on arc: " << arc << "; lowest y: " << lp.y << ", sweepline y: " << sweepLineY << ".\n";
+    // Converging breakpoints always meet at or below the sweep line. The computed circle
+    // can still end up a rounding error above it, e.g. for co-circular sites, and the
+    // event must not be lost for that.
+    auto cc = circumcircle(prev->location, arc->location, next->location);
+    double y = std::max(lowestPoint(cc).y, sweepLineY);
 
-    int eventIndex = events.size();
-    events.push_back(Event::Vertex(arc->site, lp.y));
-    arcEvents[arc->id] = eventIndex;
-    eventQueue.insert({ static_cast<int>(round(lp.y)), eventIndex });
+    TORA_TRACE(Verbose, "adding vertex event on arc %d (site %d); lowest y: %f, sweepline y: %f", arc->id, arc->site, y, sweepLineY);
 
-    return true;
-}
+    eventQueue.pushVertex(arc, y);
 
-void State::addSiteEvent(const Site& site)
-{
-    int eventIndex = events.size();
-    events.push_back(Event::Site(site.id, site.location.y));
-    eventQueue.insert({ static_cast<int>(round(site.location.y)), eventIndex });
+    return true;
 }
 
 void State::clearVertexEvent(ArcRef arc)
 {
-    auto arcEvent = arcEvents.find(arc->id);
-
-    if (arcEvent != arcEvents.end()) {
-        std::cout << "remove vertex event with arc: " << arc << ".\n";
-        events[arcEvent->second].active = false;
-        arcEvents.erase(arcEvent);
+    if (arc->event >= 0) {
+        TORA_TRACE(Verbose, "remove vertex event with arc %d (site %d)", arc->id, arc->site);
+        eventQueue.cancel(arc);
     }
 }
 
@@ -76,30 +110,41 @@ bool State::step()
 
     while (!progress) {
 
-        if (eventQueue.empty()) {
+        Event ev;
+        if (!eventQueue.pop(ev)) {
+            if (boundary && !edgesBounded) {
+                boundEdges();
+            }
             return false;
         }
 
-        auto it = eventQueue.begin();
-        Event ev = events[it->second];
-        eventQueue.erase(it);
-
-        if (!ev.active) {
-            continue;
-        }
+        processedEvents++;
 
         sweepLineY = ev.y;
 
         if (ev.type == Event::SITE) {
 
-            std::cout << "handling site event, site: " << ev.site << ".\n";
+            TORA_TRACE(Debug, "handling site event, site: %d", ev.site);
 
             const auto& newSite = sites[ev.site];
-            auto arc = findArcAbove(beachline, newSite.location);
+            auto arc = beachline.findArcAbove(newSite.location);
 
-            if (arc == beachline.end()) {
-                std::cout << "adding first site " << ev.site << ".\n";
-                beachline.push_back(Arc{ .id = nextArcId++, .site = newSite.id, .location = newSite.location });
+            if (!arc) {
+                TORA_TRACE(Debug, "adding first site %d", ev.site);
+                beachline.pushBack(Arc{ .id = nextArcId++, .site = newSite.id, .location = newSite.location });
+            }
+            else if (arc->location.y == newSite.location.y) {
+                // Only the topmost sites can meet an arc of their own height: the arc is
+                // still a vertical ray and there is nothing to split. The new arc goes
+                // next to it, with a vertical edge between them coming down from infinity.
+                TORA_TRACE(Debug, "adding site %d next to arc %d (site %d) on the first row", ev.site, arc->id, arc->site);
+
+                auto b = beachline.insertAfter(arc, Arc{ .id = nextArcId++, .site = newSite.id, .location = newSite.location });
+                createSegments(arc, b, Point((arc->location.x + newSite.location.x) * 0.5, newSite.location.y));
+
+                int h = voronoi.addEdge(arc->site, b->site);
+                arc->rightHalfEdge = h;
+                b->leftHalfEdge = voronoi.halfEdge(h).twin;
             }
             else {
                 auto intersection = parabolaIntersect(arc->location, newSite.location);
@@ -107,23 +152,25 @@ bool State::step()
 
                 clearVertexEvent(arc);
 
-                if (arc != beachline.begin() && std::next(arc) != beachline.end()) {
-                    std::cout << "splitting arc " << arc << ".\n";
-                }
-                else {
-                    std::cout << "splitting arc " << arc->id << ".\n";
-                }
-                auto a = beachline.insert(std::next(arc), Arc{ .id = nextArcId++, .site = arc->site, .location = arc->location });
-                auto b = beachline.insert(std::next(a), Arc{ .id = nextArcId++, .site = newSite.id, .location = newSite.location });
-                auto c = beachline.insert(std::next(b), Arc{ .id = nextArcId++, .site = arc->site, .location = arc->location });
-
-                a->s1 = arc->s1;
+                TORA_TRACE(Debug, "splitting arc %d (site %d)", arc->id, arc->site);
+
+                // the arc above keeps its node as the left piece, the new arc and the
+                // right piece go in after it
+                auto a = arc;
+                auto b = beachline.insertAfter(a, Arc{ .id = nextArcId++, .site = newSite.id, .location = newSite.location });
+                auto c = beachline.insertAfter(b, Arc{ .id = nextArcId++, .site = a->site, .location = a->location });
+
+                c->s2 = a->s2;
                 createSegments(a, b, intersection);
                 createSegments(b, c, intersection);
-                c->s2 = arc->s2;
 
-                beachline.erase(arc);
-               
+                // one new edge between the two sites, traced by both new breakpoints:
+                // the new cell's half-edge runs from the a|b end to the b|c end
+                int h = voronoi.addEdge(b->site, a->site);
+                c->rightHalfEdge = a->rightHalfEdge;
+                b->leftHalfEdge = b->rightHalfEdge = h;
+                a->rightHalfEdge = c->leftHalfEdge = voronoi.halfEdge(h).twin;
+
                 checkVertexEvent(a, sweepLineY);
                 checkVertexEvent(c, sweepLineY);
             }
@@ -131,54 +178,46 @@ bool State::step()
             progress = true;
         }
         else {
-            std::cout << "handling vertex event, site: " << ev.site << ".\n";
-
-            ArcRef arc = beachline.end();
-            for (ArcRef it = std::next(beachline.begin()); it != beachline.end(); it++) {
-                if (it->site == ev.site && it != beachline.end() && std::next(it) != beachline.end()) {
-                    auto bp1 = breakpoint(std::prev(it)->location, it->location, sweepLineY);
-                    auto bp2 = breakpoint(it->location, std::next(it)->location, sweepLineY);
-                    if (distSqr(bp1, bp2) < 1e-3) {
-                        arc = it;
-                        break;
-                    }
-                }
-            }
-
-            if (arc == beachline.end()) {
-                std::cout << "did not find arc for vertex event.\n";
-                continue;
-            }
-            else {
-                std::cout << "collapsing arc " << arc << ".\n";
-            }
+            TORA_TRACE(Debug, "handling vertex event, site: %d", ev.site);
 
-            auto prev = std::prev(arc);
-            auto next = std::next(arc);
+            // an active event always has both neighbors: any change to them
+            // re-checks this arc and would have cancelled the event
+            ArcRef arc = ev.arc;
 
-            // Check if this circle event is still valid
-            if (prev == beachline.begin() || std::next(next) == beachline.end()) {
-                continue;  // Skip this event, it's no longer valid
-            }
+            auto prev = arc->prev;
+            auto next = arc->next;
 
             auto cc = circumcircle(arc->location, prev->location, next->location);
 
-            voronoiVertices.push_back(cc.origin);
+            int vertex = voronoi.addVertex(cc.origin);
 
-            std::cout << "collapsing arc " << arc << " and adding voronoi vertex at(" << cc.origin.x << ", " << cc.origin.y << ").\n";
+            TORA_TRACE(Debug, "collapsing arc %d (sites %d,%d,%d) and adding voronoi vertex at (%f, %f)",
+                arc->id, prev->site, arc->site, next->site, cc.origin.x, cc.origin.y);
 
             createSegments(prev, next, cc.origin);
 
             if (arc->s1 >= 0) {
-                std::cout << "connect arc " << arc << " with new vertex on the left end.\n";
+                TORA_TRACE(Verbose, "connect arc %d with new vertex on the left end", arc->id);
                 segments[arc->s1].finish(cc.origin);
             }
             if (arc->s2 >= 0) {
-                std::cout << "connect arc " << arc << " with new vertex on the right end.\n";
+                TORA_TRACE(Verbose, "connect arc %d with new vertex on the right end", arc->id);
                 segments[arc->s2].finish(cc.origin);
             }
             
-            clearVertexEvent(arc);
+            // the edges on both sides of the arc end here and a new one between
+            // prev and next starts; see Voronoi for the orientation
+            int h = voronoi.addEdge(prev->site, next->site);
+            int twin = voronoi.halfEdge(h).twin;
+            voronoi.setOrigin(arc->leftHalfEdge, vertex);
+            voronoi.setOrigin(next->leftHalfEdge, vertex);
+            voronoi.setOrigin(h, vertex);
+            voronoi.link(arc->rightHalfEdge, arc->leftHalfEdge);
+            voronoi.link(prev->rightHalfEdge, h);
+            voronoi.link(twin, next->leftHalfEdge);
+            prev->rightHalfEdge = h;
+            next->leftHalfEdge = twin;
+
             beachline.erase(arc);
 
             checkVertexEvent(prev, sweepLineY);
@@ -188,11 +227,16 @@ bool State::step()
         }
     }
 
-    std::cout << "current beachline: ";
-    for (auto& arc : beachline) {
-        std::cout << arc.id << "(" << arc.site << ") ";
+    if constexpr (trace::enabled(trace::Level::Verbose)) {
+        // pack as many arcs as fit in one record
+        char line[trace::RingBuffer::kRecordSize];
+        size_t len = 0;
+        line[0] = '\0';
+        for (auto arc = beachline.front(); arc && len < sizeof(line); arc = arc->next) {
+            len += std::snprintf(line + len, sizeof(line) - len, "%d(%d) ", arc->id, arc->site);
+        }
+        TORA_TRACE(Verbose, "current beachline: %s", line);
     }
-    std::cout << "\n" << std::endl;
 
     return progress;
 }
@@ -202,9 +246,49 @@ void State::run()
     while (step());
 }
 
-State::State(const std::vector<Site>& sites) : sites { sites } {
-    for (const auto& site : this->sites) {
-        addSiteEvent(site);
+void State::boundEdges()
+{
+    // The edges still open are exactly the breakpoints left on the beachline. Each one
+    // moves perpendicular to its two sites, and arc->rightHalfEdge ends at the moving end.
+    for (auto arc = beachline.front(); arc && arc->next; arc = arc->next) {
+        auto left = arc->location;
+        auto right = arc->next->location;
+        auto direction = Point(left.y - right.y, right.x - left.x);
+
+        int h = arc->rightHalfEdge;
+        int origin = voronoi.origin(h);
+
+        // edges open at both ends are whole bisector lines, the first end to be bounded
+        // becomes the origin of the other
+        Point exit;
+        bool hit = origin >= 0
+            ? exitPoint(*boundary, voronoi.vertex(origin), direction, true, exit)
+            : exitPoint(*boundary, (left + right) * 0.5, direction, false, exit);
+        if (!hit) {
+            TORA_TRACE(Debug, "edge between sites %d and %d misses the boundary", arc->site, arc->next->site);
+            continue;
+        }
+
+        voronoi.setOrigin(voronoi.halfEdge(h).twin, voronoi.addVertex(exit));
+        if (arc->s2 >= 0 && !segments[arc->s2].finished) {
+            segments[arc->s2].finish(exit);
+        }
+    }
+
+    edgesBounded = true;
+}
+
+State::State(const std::vector<Site>& sites) : sites{ sites }, eventQueue{ this->sites } {
+    voronoi.reserve(sites.size());
+    for (const auto& site : sites) {
+        voronoi.addCell(site.location);
+    }
+}
+
+State::State(const std::vector<Site>& sites, const Polygon& boundary) : State{ sites } {
+    this->boundary = boundary;
+    if (geometry::windingDirection(*this->boundary) < 0) {
+        std::reverse(this->boundary->vertices.begin(), this->boundary->vertices.end());
     }
 }
 
@@ -247,61 +331,116 @@ std::optional<State> State::load(const std::string& filename) {
 }
 
 
-// note this function destroys the list in argument
-bool toPolygon(std::list<Segment>& segments, Polygon& outPolygon) {
-    outPolygon.vertices.clear();
-
-    int n = segments.size();
-    auto seg = segments.begin();
-    Point p = seg->b;
-    seg = segments.erase(seg);
+CellPolygons State::getCellPolygons() const
+{
+    // Cells are read straight off the half-edge structure: every corner is a shared vertex
+    // index, so there is nothing to match and each half-edge is visited twice in total.
+    // Cells are taken in the order their first half-edge was created, i.e. sweep order,
+    // which keeps the walks local in memory; site order would jump all over the arrays.
+    const auto& halfEdges = voronoi.halfEdges();
+    const auto& cells = voronoi.cells();
+
+    CellPolygons result;
+    result.offsets.push_back(0);
+
+    // cells that cross the boundary or run off to infinity, bounded mode only
+    std::vector<int> clipped;
+    std::vector<int> clipIndex(boundary ? cells.size() : 0, -1);
+
+    // first pass: find closed cells and lay out the offsets
+    for (int h = 0; h < static_cast<int>(halfEdges.size()); h++) {
+        int c = halfEdges[h].cell;
+        if (cells[c].halfEdge != h) {
+            continue;
+        }
 
-    outPolygon.vertices.push_back(p);
-    for (int i = 0; i < n - 1; i++) {
-        for (auto it = segments.begin(); it != segments.end(); it++) {
-            if (geometry::pointEq(it->a, p, 0.1)) {
-                p = it->b;
-                segments.erase(it);
-                break;
-            }
-            else if (geometry::pointEq(it->b, p, 0.1)) {
-                p = it->a;
-                segments.erase(it);
+        // hull cells are open chains, they run into a half-edge without origin or next
+        int degree = 0;
+        bool inside = true;
+        int e = h;
+        do {
+            degree++;
+            if (halfEdges[e].origin < 0) {
                 break;
             }
+            inside = inside && (!boundary || geometry::convexContains(*boundary, voronoi.vertex(halfEdges[e].origin)));
+            e = halfEdges[e].next;
+        } while (e >= 0 && e != h);
+
+        if (e == h && degree > 2 && inside) {
+            result.sites.push_back(c);
+            result.offsets.push_back(result.offsets.back() + degree);
+        }
+        else if (boundary) {
+            clipIndex[c] = static_cast<int>(clipped.size());
+            clipped.push_back(c);
         }
-        outPolygon.vertices.push_back(p);
     }
 
-    if (!segments.empty()) {
-        return false;
+    // Bounded mode: the other cells are the boundary cut down by the bisector towards
+    // each neighbor. Neighbors are found by scanning all half-edges rather than walking
+    // the cell, since the cell of a site between collinear ones has two separate chains.
+    std::vector<std::vector<Point>> clippedVertices;
+    if (boundary) {
+        for (int c = 0; c < static_cast<int>(cells.size()); c++) {
+            // a lone site has no edges at all
+            if (cells[c].halfEdge < 0) {
+                clipIndex[c] = static_cast<int>(clipped.size());
+                clipped.push_back(c);
+            }
+        }
+
+        clippedVertices.assign(clipped.size(), boundary->vertices);
+        std::vector<Point> scratch;
+        for (const auto& e : halfEdges) {
+            int i = clipIndex[e.cell];
+            if (i >= 0) {
+                geometry::clipToBisector(clippedVertices[i], cells[e.cell].site, cells[halfEdges[e.twin].cell].site, scratch);
+            }
+        }
+
+        for (size_t i = 0; i < clipped.size(); i++) {
+            // empty for sites outside the boundary
+            if (clippedVertices[i].size() > 2) {
+                result.sites.push_back(clipped[i]);
+                result.offsets.push_back(result.offsets.back() + static_cast<int>(clippedVertices[i].size()));
+            }
+        }
     }
 
-    if (geometry::windingDirection(outPolygon) < 0) {
-        std::reverse(outPolygon.vertices.begin(), outPolygon.vertices.end());
+    // second pass: fill the vertices
+    result.vertices.resize(result.offsets.back());
+    for (int i = 0; i < result.size(); i++) {
+        int c = result.sites[i];
+        int k = result.offsets[i];
+        if (boundary && clipIndex[c] >= 0) {
+            std::copy(clippedVertices[clipIndex[c]].begin(), clippedVertices[clipIndex[c]].end(), result.vertices.begin() + k);
+            continue;
+        }
+
+        int h = cells[c].halfEdge;
+        int e = h;
+        do {
+            result.vertices[k++] = voronoi.vertex(halfEdges[e].origin);
+            e = halfEdges[e].next;
+        } while (e != h);
     }
 
-    return true;
+    return result;
 }
 
-std::vector<geometry::Polygon> State::getPolygons() const
+geometry::PolygonSet State::getPolygons() const
 {
-    std::unordered_map<int, std::list<Segment>> siteSegments;
-    for (const auto& segment : segments) {
-        if (segment.finished) {
-            siteSegments[segment.site1].push_back(segment);
-            siteSegments[segment.site2].push_back(segment);
-        }
-    }
+    return toPolygons(getCellPolygons());
+}
 
-    std::vector<geometry::Polygon> result;
-    for (auto& [_, segments] : siteSegments) {
-        Polygon p;
-        if (segments.size() > 2 && toPolygon(segments, p)) {
-            result.push_back(p);
-        }
+geometry::PolygonSet toPolygons(const CellPolygons& cells)
+{
+    geometry::PolygonSet result;
+    result.reserve(cells.size(), static_cast<int>(cells.vertices.size()));
+    for (int i = 0; i < cells.size(); i++) {
+        result.append(std::span(cells.vertices.begin() + cells.offsets[i], cells.vertices.begin() + cells.offsets[i + 1]));
     }
-
     return result;
 }
 
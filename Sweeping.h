@@ -1,35 +1,23 @@
 #pragma once
 
-#include <map>
+#include <cmath>
+#include <limits>
 #include <vector>
-#include <queue>
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
 #include <iostream>
 
 #include "Geometry.h"
+#include "PolygonSet.h"
+#include "Beachline.h"
+#include "EventQueue.h"
+#include "Voronoi.h"
 
 namespace tora::sim::fortune {
 
 using namespace tora::geometry;
 
-struct Site
-{
-    int id;
-    Point location;
-};
-
-struct Arc
-{
-    int id;
-    int site;
-    Point location; // site location!
-    int s1;
-    int s2;
-    inline bool isValid() const { return site >= 0; }
-};
-
 struct Segment {
     Point a;
     Point b;
@@ -48,55 +36,55 @@ struct Segment {
     }
 };
 
-using ArcRef = std::list<Arc>::iterator;
 std::ostream& operator<<(std::ostream& os, const ArcRef& ar);
 
-struct Event {
-    int type;
-    double y;
-    int site;
-    bool active;
-    static constexpr int SITE = 0;
-    static constexpr int VERTEX = 1;
-
-    static Event Vertex(int site, double y) {
-        return Event{ .type = VERTEX, .y = y, .site = site, .active = true };
-    }
+// Closed Voronoi cells packed in one vertex array. Unbounded, hull cells are left out;
+// with a boundary every site inside it has a cell.
+// Polygon i belongs to site sites[i], its vertices are vertices[offsets[i] .. offsets[i + 1])
+// with positive winding (see geometry::windingDirection).
+struct CellPolygons
+{
+    std::vector<int> sites;
+    std::vector<int> offsets;
+    std::vector<Point> vertices;
 
-    static Event Site(int site, double y) {
-        return Event{ .type = SITE, .y = y, .site = site, .active = true };
-    }
+    int size() const { return static_cast<int>(sites.size()); }
 };
 
+geometry::PolygonSet toPolygons(const CellPolygons& cells);
+
 struct State
 {
-    using EventId = int;
-
     std::vector<Site> sites;
-    std::list<Arc> beachline;
-
-    std::unordered_map<int, EventId> arcEvents;
+    Beachline beachline;
+    EventQueue eventQueue;
 
-    std::vector<Event> events;
-    std::multimap<int, EventId> eventQueue;
-    
     std::vector<Point> midPoints;
-    std::vector<Point> voronoiVertices;
     std::vector<Segment> segments;
+    Voronoi voronoi;
 
     double sweepLineY = 0;
     int nextArcId = 0;
+    size_t processedEvents = 0;
+
+    // Optional convex clip polygon with positive winding. When set, the edges still open
+    // at the end of the sweep are cut off where they leave it, and every cell is clipped
+    // to it, so hull sites get closed cells too.
+    std::optional<Polygon> boundary;
+    bool edgesBounded = false;
 
     State(const std::vector<Site>& sites);
+    State(const std::vector<Site>& sites, const Polygon& boundary);
     bool step();
     void run();
+    void boundEdges();
 
-    void addSiteEvent(const Site& site);
     bool checkVertexEvent(ArcRef arc, double sweepLineY);
     void clearVertexEvent(ArcRef arc);
     int createSegments(ArcRef a, ArcRef b, Point s);
 
-    std::vector<geometry::Polygon> getPolygons() const;
+    CellPolygons getCellPolygons() const;
+    geometry::PolygonSet getPolygons() const;
 
     void save(const std::string& filename);
     static std::optional<State> load(const std::string& filename);
@@ -132,6 +120,23 @@ inline Point lowestPoint(const Circle& c)
 inline Point breakpoint(Point p1, Point p2, double l)
 {
     double x1 = p1.x, y1 = p1.y, x2 = p2.x, y2 = p2.y;
+
+    // A site on the sweep line has no parabola yet, only a vertical ray up from it;
+    // sites of equal height meet on their vertical bisector.
+    if (y1 == l && y2 == l) {
+        return Point((x1 + x2) * 0.5, -std::numeric_limits<double>::infinity());
+    }
+    if (y1 == l) {
+        return Point(x1, ((x1 - x2) * (x1 - x2) + y2 * y2 - l * l) / (2 * y2 - 2 * l));
+    }
+    if (y1 == y2) {
+        double x = (x1 + x2) * 0.5;
+        return Point(x, (x * x - 2 * x1 * x + x1 * x1 + y1 * y1 - l * l) / (2 * y1 - 2 * l));
+    }
+    if (y2 == l) {
+        return Point(x2, ((x2 - p1.x) * (x2 - p1.x) + y1 * y1 - l * l) / (2 * y1 - 2 * l));
+    }
+
     double d1 = 1.0 / (2.0 * (y1 - l));
     double d2 = 1.0 / (2.0 * (y2 - l));
     double a = d1 - d2;
@@ -144,28 +149,17 @@ inline Point breakpoint(Point p1, Point p2, double l)
     return Point(x, y);
 }
 
-inline std::vector<Point> breakpoints(std::list<Arc>& beachline, double sweepLineY)
+inline std::vector<Point> breakpoints(const Beachline& beachline, double sweepLineY)
 {
     auto bps = std::vector<Point>();
-    auto it = beachline.begin();
-    if (it != beachline.end()) {
-        for (auto next = std::next(it); it != beachline.end() && next != beachline.end(); it++, next++) {
-            bps.emplace_back(breakpoint(it->location, next->location, sweepLineY));
-        }
+    for (auto arc = beachline.front(); arc && arc->next; arc = arc->next) {
+        bps.emplace_back(breakpoint(arc->location, arc->next->location, sweepLineY));
     }
     return bps;
 }
 
-inline ArcRef findArcAbove(std::list<Arc>& beachline, Point p) {
-    auto it = beachline.begin();
-    if (it != beachline.end()) {
-        for (auto next = std::next(it); it != beachline.end() && next != beachline.end(); it++, next++) {
-            if (p.x < breakpoint(it->location, next->location, p.y).x) {
-                return it;
-            }
-        }
-    }
-    return it;
+inline ArcRef findArcAbove(const Beachline& beachline, Point p) {
+    return beachline.findArcAbove(p);
 }
 
 inline Point parabolaIntersect(Point siteAbove, Point newSite) {
@@ -0,0 +1,136 @@
+#include "ThreadPool.h"
+
+namespace tora {
+
+namespace {
+
+// the pool the calling thread works for, and its index there
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    queues_.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<Worker>());
+    }
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{ sleepMutex_ };
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& w : workers_) w.join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::currentWorker() const
+{
+    return currentPool == this ? currentIndex : queues_.size();
+}
+
+void ThreadPool::push(Task task)
+{
+    if (queues_.empty()) {
+        task();
+        return;
+    }
+
+    size_t self = currentWorker();
+    size_t q = self < queues_.size() ? self : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard lock{ queues_[q]->mutex };
+        queues_[q]->tasks.push_back(std::move(task));
+    }
+    {
+        // under the lock so that a worker about to sleep cannot miss it
+        std::lock_guard lock{ sleepMutex_ };
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop(size_t self, Task& task)
+{
+    auto& worker = *queues_[self];
+    std::lock_guard lock{ worker.mutex };
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t self, Task& task)
+{
+    const size_t n = queues_.size();
+    for (size_t k = 1; k <= n; k++) {
+        auto& victim = *queues_[(self + k) % n];
+        std::unique_lock lock{ victim.mutex, std::try_to_lock };
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::runPendingTask()
+{
+    if (pending_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    Task task;
+    size_t self = currentWorker();
+    if (!(self < queues_.size() && pop(self, task)) && !steal(self, task)) {
+        return false;
+    }
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        if (runPendingTask()) {
+            continue;
+        }
+
+        std::unique_lock lock{ sleepMutex_ };
+        // a steal can fail on a contended deque, so pending work means try again;
+        // the pool drains its queues before it stops
+        if (pending_.load(std::memory_order_relaxed) > 0) {
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        if (stop_) {
+            return;
+        }
+        wake_.wait(lock, [this] { return stop_ || pending_.load(std::memory_order_relaxed) > 0; });
+    }
+}
+
+} // namespace tora
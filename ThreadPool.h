@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tora {
+
+// Work-stealing thread pool.
+//
+// Every worker owns a deque of tasks. A worker pushes and pops its own tasks at the back,
+// newest first, and when it runs dry it steals the oldest task from the front of another
+// worker's deque. Tasks submitted from outside the pool are dealt round-robin.
+//
+// Threads that wait on the pool (parallelFor, wait) run pending tasks while they wait,
+// so it is fine to call parallelFor from inside a task.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads runs every task on the calling thread
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // process-wide pool with one worker per hardware thread
+    static ThreadPool& shared();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    // Queues f and returns a future for its result; exceptions thrown by f end up in it.
+    template <class F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        push([task] { (*task)(); });
+        return future;
+    }
+
+    // Blocks until the future is ready, running pending tasks meanwhile.
+    template <class R>
+    R wait(std::future<R>& future)
+    {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+        return future.get();
+    }
+
+    // Calls f(first, last) over [0, count) split into chunks of about grain items, and
+    // returns once all of them are done. Chunk bounds depend only on count and grain, not
+    // on the number of threads. The first exception thrown by f is rethrown here.
+    template <class F>
+    void parallelFor(size_t count, size_t grain, F&& f)
+    {
+        if (count == 0) {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        const size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1 || workers_.empty()) {
+            for (size_t first = 0; first < count; first += grain) {
+                f(first, std::min(first + grain, count));
+            }
+            return;
+        }
+
+        struct Shared
+        {
+            std::atomic<size_t> remaining;
+            std::mutex errorMutex{};
+            std::exception_ptr error{};
+        } shared{ .remaining = chunks };
+
+        // the calling thread takes the first chunk itself
+        for (size_t c = 1; c < chunks; c++) {
+            push([&shared, &f, c, grain, count] {
+                try {
+                    f(c * grain, std::min((c + 1) * grain, count));
+                }
+                catch (...) {
+                    std::lock_guard lock{ shared.errorMutex };
+                    if (!shared.error) {
+                        shared.error = std::current_exception();
+                    }
+                }
+                shared.remaining.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+        try {
+            f(0, std::min(grain, count));
+        }
+        catch (...) {
+            std::lock_guard lock{ shared.errorMutex };
+            if (!shared.error) {
+                shared.error = std::current_exception();
+            }
+        }
+        shared.remaining.fetch_sub(1, std::memory_order_acq_rel);
+
+        while (shared.remaining.load(std::memory_order_acquire) > 0) {
+            if (!runPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+        if (shared.error) {
+            std::rethrow_exception(shared.error);
+        }
+    }
+
+    // Pops one task, from this worker's own deque first, and runs it.
+    // Returns false if there was nothing to run.
+    bool runPendingTask();
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(Task task);
+    bool pop(size_t self, Task& task);
+    bool steal(size_t self, Task& task);
+    void workerLoop(size_t index);
+
+    // index of the calling thread's worker in this pool, or size() from outside
+    size_t currentWorker() const;
+
+    std::vector<std::unique_ptr<Worker>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{ 0 };
+    std::atomic<size_t> nextQueue_{ 0 };
+    bool stop_ = false;
+};
+
+} // namespace tora
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Compile-time leveled tracing.
+//
+//     TORA_TRACE(Debug, "splitting arc %d", arc->id);
+//
+// Statements above TORA_TRACE_LEVEL are discarded at compile time, arguments included,
+// so release builds (NDEBUG, level 0 by default) carry no trace code at all.
+// Enabled statements format into a ring buffer owned by the calling thread: no locks,
+// no allocation after the first write, no stream I/O. Call trace::dump() or
+// trace::dumpAll() to read the buffers back.
+
+#ifndef TORA_TRACE_LEVEL
+#ifdef NDEBUG
+#define TORA_TRACE_LEVEL 0
+#else
+#define TORA_TRACE_LEVEL 2
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TORA_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define TORA_PRINTF_FORMAT(fmt, args)
+#endif
+
+#define TORA_TRACE(level, ...) \
+    do { \
+        if constexpr (::tora::trace::enabled(::tora::trace::Level::level)) { \
+            ::tora::trace::write(::tora::trace::Level::level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+namespace tora::trace {
+
+enum class Level : int
+{
+    Off = 0,
+    Info = 1,
+    Debug = 2,
+    Verbose = 3,
+};
+
+constexpr bool enabled(Level level)
+{
+    return static_cast<int>(level) <= TORA_TRACE_LEVEL;
+}
+
+inline const char* levelName(Level level)
+{
+    switch (level) {
+    case Level::Info: return "info";
+    case Level::Debug: return "debug";
+    case Level::Verbose: return "verbose";
+    default: return "off";
+    }
+}
+
+// Fixed-size ring of preformatted records. Only the owning thread writes to it;
+// older records are overwritten once the ring is full.
+class RingBuffer
+{
+public:
+    static constexpr size_t kCapacity = 2048;
+    static constexpr size_t kRecordSize = 120;
+
+    explicit RingBuffer(std::thread::id owner) : owner_{ owner } {}
+
+    void write(Level level, const char* format, va_list args)
+    {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        auto& record = records_[head % kCapacity];
+        record.level = level;
+        std::vsnprintf(record.text, kRecordSize, format, args);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // oldest record first
+    void dump(std::ostream& os) const
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t begin = head > kCapacity ? head - kCapacity : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const auto& record = records_[i % kCapacity];
+            os << "[" << levelName(record.level) << "] " << record.text << "\n";
+        }
+    }
+
+    void clear() { head_.store(0, std::memory_order_release); }
+
+    std::thread::id owner() const { return owner_; }
+
+private:
+    struct Record
+    {
+        Level level;
+        char text[kRecordSize];
+    };
+
+    std::array<Record, kCapacity> records_;
+    std::atomic<uint64_t> head_ = 0;
+    std::thread::id owner_;
+};
+
+namespace detail {
+
+// Buffers outlive their threads so that a crashed or finished worker can still be dumped.
+// The mutex is only taken when a thread writes its first record and when dumping all.
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<RingBuffer>> buffers;
+};
+
+inline Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+inline RingBuffer& localBuffer()
+{
+    thread_local std::shared_ptr<RingBuffer> buffer = [] {
+        auto b = std::make_shared<RingBuffer>(std::this_thread::get_id());
+        std::lock_guard lock{ registry().mutex };
+        registry().buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+} // namespace detail
+
+TORA_PRINTF_FORMAT(2, 3)
+inline void write(Level level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    detail::localBuffer().write(level, format, args);
+    va_end(args);
+}
+
+// Dumps the calling thread's records.
+inline void dump(std::ostream& os)
+{
+    detail::localBuffer().dump(os);
+}
+
+// Dumps every thread's records. Records still being written by other threads may
+// come out garbled, so call this once the workers are idle or joined.
+inline void dumpAll(std::ostream& os)
+{
+    std::lock_guard lock{ detail::registry().mutex };
+    for (const auto& buffer : detail::registry().buffers) {
+        os << "--- thread " << buffer->owner() << "\n";
+        buffer->dump(os);
+    }
+}
+
+} // namespace tora::trace
@@ -1,29 +1,147 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 
 #include "Geometry.h"
 
 namespace tora::geometry {
 
-struct Site
+// Voronoi diagram as a half-edge structure (DCEL).
+//
+// Every Voronoi edge is a pair of twin half-edges, one on each of the two cells it
+// separates. The half-edges of a cell are chained by next/prev and keep the cell on the
+// same side: walking next goes down the right side of the cell and back up its left
+// side in screen coordinates, i.e. the positive winding of windingDirection().
+// Vertices are shared by index; a half-edge ends where its twin begins.
+//
+// Edges that run off to infinity have no vertex on that end (origin < 0) and no
+// neighbor on that side (next/prev < 0), so cells on the hull are open chains.
+class Voronoi
 {
-    int id;
-};
+public:
+    struct Cell
+    {
+        Point site;
+        int halfEdge = -1; // any half-edge on the boundary, -1 if the cell has none
+    };
 
-struct Edge
-{
-    int v1;
-    int v2;
-};
+    struct HalfEdge
+    {
+        int origin = -1; // vertex index, -1 if the edge starts at infinity
+        int twin = -1;
+        int next = -1;
+        int prev = -1;
+        int cell = -1;
+    };
 
-class Voronoi
-{
-    std::vector<Site> sites;
-    std::vector<Point> vertices;
-    std::vector<Edge> edges;
-    std::unordered_map<int, std::vector<Edge>> siteEdges;
+    Voronoi() = default;
+
+    void reserve(int numSites)
+    {
+        cells_.reserve(numSites);
+        // a diagram of n sites has at most 2n - 5 vertices and 3n - 6 edges
+        vertices_.reserve(2 * numSites);
+        halfEdges_.reserve(6 * numSites);
+    }
+
+    void clear()
+    {
+        cells_.clear();
+        vertices_.clear();
+        halfEdges_.clear();
+    }
+
+    int addCell(Point site)
+    {
+        cells_.push_back(Cell{ .site = site });
+        return static_cast<int>(cells_.size()) - 1;
+    }
+
+    int addVertex(Point p)
+    {
+        vertices_.push_back(p);
+        return static_cast<int>(vertices_.size()) - 1;
+    }
+
+    // Adds the edge between two cells and returns its half-edge on cellA.
+    // The twin on cellB is always the following index.
+    int addEdge(int cellA, int cellB)
+    {
+        int h = static_cast<int>(halfEdges_.size());
+        halfEdges_.push_back(HalfEdge{ .twin = h + 1, .cell = cellA });
+        halfEdges_.push_back(HalfEdge{ .twin = h, .cell = cellB });
+        for (int c : { cellA, cellB }) {
+            if (cells_[c].halfEdge < 0) {
+                cells_[c].halfEdge = c == cellA ? h : h + 1;
+            }
+        }
+        return h;
+    }
+
+    void setOrigin(int h, int vertex) { halfEdges_[h].origin = vertex; }
+
+    void link(int h, int next)
+    {
+        halfEdges_[h].next = next;
+        halfEdges_[next].prev = h;
+    }
+
+    const std::vector<Cell>& cells() const { return cells_; }
+    const std::vector<Point>& vertices() const { return vertices_; }
+    const std::vector<HalfEdge>& halfEdges() const { return halfEdges_; }
+
+    const Cell& cell(int c) const { return cells_[c]; }
+    const HalfEdge& halfEdge(int h) const { return halfEdges_[h]; }
+    const Point& vertex(int v) const { return vertices_[v]; }
+
+    int origin(int h) const { return halfEdges_[h].origin; }
+    int destination(int h) const { return halfEdges_[halfEdges_[h].twin].origin; }
+
+    // Walks the boundary of a cell in next order, calling f(halfEdge) once per half-edge.
+    // Open cells are walked from the start of their chain to its end; the cell of a site
+    // between collinear ones has two chains, only the one holding Cell::halfEdge is walked.
+    template <class F>
+    void forEachHalfEdge(int c, F&& f) const
+    {
+        int first = cells_[c].halfEdge;
+        if (first < 0) {
+            return;
+        }
+
+        // rewind open chains to their first half-edge
+        int start = first;
+        while (halfEdges_[start].prev >= 0 && halfEdges_[start].prev != first) {
+            start = halfEdges_[start].prev;
+        }
+
+        int h = start;
+        do {
+            f(h);
+            h = halfEdges_[h].next;
+        } while (h >= 0 && h != start);
+    }
+
+    // Calls f(neighborCell, halfEdge) for every cell sharing an edge with c.
+    template <class F>
+    void forEachNeighbor(int c, F&& f) const
+    {
+        forEachHalfEdge(c, [&](int h) { f(halfEdges_[halfEdges_[h].twin].cell, h); });
+    }
+
+    // a cell is closed when its half-edges form a cycle with a vertex at every corner
+    bool isClosed(int c) const
+    {
+        bool closed = cells_[c].halfEdge >= 0;
+        forEachHalfEdge(c, [&](int h) {
+            closed = closed && halfEdges_[h].origin >= 0 && halfEdges_[h].next >= 0;
+        });
+        return closed;
+    }
+
+private:
+    std::vector<Cell> cells_;
+    std::vector<Point> vertices_;
+    std::vector<HalfEdge> halfEdges_;
 };
 
-} // namespace tora::geometry
\ No newline at end of file
+} // namespace tora::geometry
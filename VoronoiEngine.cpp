@@ -0,0 +1,103 @@
+#include "VoronoiEngine.h"
+#include "DelaunayVoronoi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tora::sim {
+
+const char* engineName(VoronoiEngine engine)
+{
+    switch (engine) {
+    case VoronoiEngine::Fortune: return "fortune";
+    case VoronoiEngine::Delaunay: return "delaunay";
+    }
+    return "unknown";
+}
+
+std::optional<VoronoiEngine> parseEngine(const std::string& name)
+{
+    for (auto engine : { VoronoiEngine::Fortune, VoronoiEngine::Delaunay }) {
+        if (name == engineName(engine)) {
+            return engine;
+        }
+    }
+    return std::nullopt;
+}
+
+fortune::CellPolygons computeCells(VoronoiEngine engine, const std::vector<fortune::Site>& sites,
+    const std::optional<geometry::Polygon>& boundary)
+{
+    if (engine == VoronoiEngine::Delaunay) {
+        return delaunay::Dual{ sites }.getCellPolygons(boundary);
+    }
+
+    auto state = boundary ? fortune::State{ sites, *boundary } : fortune::State{ sites };
+    state.run();
+    return state.getCellPolygons();
+}
+
+namespace {
+
+// largest distance from a corner of a to its nearest corner of b
+double directedDistance(const fortune::CellPolygons& a, int i, const fortune::CellPolygons& b, int j)
+{
+    double result = 0;
+    for (int u = a.offsets[i]; u < a.offsets[i + 1]; u++) {
+        double nearest = std::numeric_limits<double>::infinity();
+        for (int v = b.offsets[j]; v < b.offsets[j + 1]; v++) {
+            nearest = std::min(nearest, geometry::distSqr(a.vertices[u], b.vertices[v]));
+        }
+        result = std::max(result, nearest);
+    }
+    return std::sqrt(result);
+}
+
+std::vector<int> cellIndexBySite(const fortune::CellPolygons& cells, int numSites)
+{
+    std::vector<int> index(numSites, -1);
+    for (int i = 0; i < cells.size(); i++) {
+        index[cells.sites[i]] = i;
+    }
+    return index;
+}
+
+} // namespace
+
+CellComparison compareCells(const fortune::CellPolygons& first, const fortune::CellPolygons& second, double tolerance)
+{
+    int numSites = 0;
+    for (int site : first.sites) numSites = std::max(numSites, site + 1);
+    for (int site : second.sites) numSites = std::max(numSites, site + 1);
+
+    auto firstIndex = cellIndexBySite(first, numSites);
+    auto secondIndex = cellIndexBySite(second, numSites);
+
+    CellComparison result;
+    for (int site = 0; site < numSites; site++) {
+        int i = firstIndex[site];
+        int j = secondIndex[site];
+        if (i < 0 && j < 0) {
+            continue;
+        }
+        if (j < 0) {
+            result.onlyInFirst++;
+            continue;
+        }
+        if (i < 0) {
+            result.onlyInSecond++;
+            continue;
+        }
+
+        double distance = std::max(directedDistance(first, i, second, j), directedDistance(second, j, first, i));
+        result.maxDistance = std::max(result.maxDistance, distance);
+        if (distance > tolerance) {
+            result.mismatched++;
+        }
+    }
+
+    return result;
+}
+
+} // namespace tora::sim
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Geometry.h"
+#include "Sweeping.h"
+
+namespace tora::sim {
+
+enum class VoronoiEngine
+{
+    Fortune,  // sweep line, see fortune::State
+    Delaunay, // dual of delaunator's triangulation, see delaunay::Dual
+};
+
+const char* engineName(VoronoiEngine engine);
+std::optional<VoronoiEngine> parseEngine(const std::string& name);
+
+// Voronoi cells of the sites computed by the given engine, clipped to boundary if set.
+// Both engines produce the same layout and winding, see fortune::CellPolygons.
+fortune::CellPolygons computeCells(VoronoiEngine engine, const std::vector<fortune::Site>& sites,
+    const std::optional<geometry::Polygon>& boundary = std::nullopt);
+
+struct CellComparison
+{
+    int onlyInFirst = 0;
+    int onlyInSecond = 0;
+    int mismatched = 0;     // cells in both whose corners differ by more than the tolerance
+    double maxDistance = 0; // largest corner distance over the cells in both
+
+    bool identical() const { return onlyInFirst == 0 && onlyInSecond == 0 && mismatched == 0; }
+};
+
+// Matches cells by site. Corners are compared as sets, every corner of one cell
+// against the nearest corner of the other, so start vertex and duplicated corners of
+// degenerate vertices do not count as differences.
+CellComparison compareCells(const fortune::CellPolygons& first, const fortune::CellPolygons& second, double tolerance);
+
+} // namespace tora::sim
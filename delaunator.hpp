@@ -36,6 +36,8 @@
 #include <utility>
 #include <vector>
 
+#include "Predicates.h"
+
 namespace delaunator {
 
     //@see https://stackoverflow.com/questions/33333363/built-in-mod-vs-custom-mod-function-improve-the-performance-of-modulus-op/33333636#33333636
@@ -101,7 +103,8 @@ namespace delaunator {
         const double qy,
         const double rx,
         const double ry) {
-        return (qy - py) * (rx - qx) - (qx - px) * (ry - qy) < 0.0;
+        // exact sign of (qy - py) * (rx - qx) - (qx - px) * (ry - qy) < 0
+        return tora::geometry::orient2d(px, py, qx, qy, rx, ry) > 0.0;
     }
 
     inline std::pair<double, double> circumcenter(
@@ -160,20 +163,8 @@ namespace delaunator {
         const double cy,
         const double px,
         const double py) {
-        const double dx = ax - px;
-        const double dy = ay - py;
-        const double ex = bx - px;
-        const double ey = by - py;
-        const double fx = cx - px;
-        const double fy = cy - py;
-
-        const double ap = dx * dx + dy * dy;
-        const double bp = ex * ex + ey * ey;
-        const double cp = fx * fx + fy * fy;
-
-        return (dx * (ey * cp - bp * fy) -
-            dy * (ex * cp - bp * fx) +
-            ap * (ex * fy - ey * fx)) < 0.0;
+        // exact sign of the lifted determinant of a, b, c relative to p
+        return tora::geometry::incircle(ax, ay, bx, by, cx, cy, px, py) < 0.0;
     }
 
     constexpr double EPSILON = std::numeric_limits<double>::epsilon();
@@ -234,7 +225,7 @@ namespace delaunator {
         void link(std::size_t a, std::size_t b);
     };
 
-    Delaunator::Delaunator(std::vector<double> const& in_coords)
+    inline Delaunator::Delaunator(std::vector<double> const& in_coords)
         : coords(in_coords),
         triangles(),
         halfedges(),
@@ -457,7 +448,7 @@ namespace delaunator {
         }
     }
 
-    double Delaunator::get_hull_area() {
+    inline double Delaunator::get_hull_area() {
         std::vector<double> hull_area;
         size_t e = hull_start;
         do {
@@ -467,7 +458,7 @@ namespace delaunator {
         return sum(hull_area);
     }
 
-    std::size_t Delaunator::legalize(std::size_t a) {
+    inline std::size_t Delaunator::legalize(std::size_t a) {
         std::size_t i = 0;
         std::size_t ar = 0;
         m_edge_stack.clear();
@@ -578,7 +569,7 @@ namespace delaunator {
             m_hash_size);
     }
 
-    std::size_t Delaunator::add_triangle(
+    inline std::size_t Delaunator::add_triangle(
         std::size_t i0,
         std::size_t i1,
         std::size_t i2,
@@ -595,7 +586,7 @@ namespace delaunator {
         return t;
     }
 
-    void Delaunator::link(const std::size_t a, const std::size_t b) {
+    inline void Delaunator::link(const std::size_t a, const std::size_t b) {
         std::size_t s = halfedges.size();
         if (a == s) {
             halfedges.push_back(b);
@@ -6,6 +6,8 @@
 
 #include "GridMap.h"
 #include "Sweeping.h"
+#include "PolygonIndex.h"
+#include "VoronoiEngine.h"
 
 struct CircumcircleTest {
     std::vector<tora::sim::fortune::Point> sites;
@@ -142,7 +144,7 @@ struct ParabolaTest {
 };
 
 struct BeachlineTest {
-    std::list<tora::sim::fortune::Arc> beachline;
+    tora::sim::fortune::Beachline beachline;
 
     void render(sf::RenderWindow& window) {
 
@@ -150,10 +152,10 @@ struct BeachlineTest {
         auto breakpoints = tora::sim::fortune::breakpoints(beachline, newSite.y);
         auto arcAbove = findArcAbove(beachline, tora::sim::fortune::Point(newSite.x, newSite.y));
 
-        for (const auto& arc : beachline) {
+        for (auto arc = beachline.front(); arc; arc = arc->next) {
             auto v = sf::CircleShape(5);
-            v.setPosition(arc.location.x - 5, arc.location.y - 5);
-            if (arc.site == arcAbove->site) {
+            v.setPosition(arc->location.x - 5, arc->location.y - 5);
+            if (arc->site == arcAbove->site) {
                 v.setFillColor(sf::Color::Green);
             }
             else {
@@ -184,7 +186,7 @@ struct BeachlineTest {
         double x = 75 + approxStep * random.getRandomBetween<double>(0.5, 1.5);
         double y = 250 + approxStep * (random.getRandomBetween<double>(0, 2.0) - 1.0);
         for (int i = 0; i < numSites; i++) {
-            t.beachline.push_back(tora::sim::fortune::Arc{
+            t.beachline.pushBack(tora::sim::fortune::Arc{
                 .id = -1,
                 .site = i,
                 .location = tora::sim::fortune::Point(x, y),
@@ -243,10 +245,22 @@ struct GenerateSitesTest {
     }
 };
 
+// Voronoi cells are clipped to this square, with a margin around the area the sites are drawn from
+tora::geometry::Polygon siteBoundary() {
+    return tora::geometry::Polygon{
+        .vertices = {
+            tora::geometry::Point(100, 100),
+            tora::geometry::Point(700, 100),
+            tora::geometry::Point(700, 700),
+            tora::geometry::Point(100, 700),
+        }
+    };
+}
+
 struct SweepingTest {
     tora::sim::fortune::State algorithm;
 
-    SweepingTest(const std::vector<tora::sim::fortune::Site>& sites) : algorithm{ sites } {}
+    SweepingTest(const std::vector<tora::sim::fortune::Site>& sites) : algorithm{ sites, siteBoundary() } {}
 
     void step() {
         if (!algorithm.step()) {
@@ -315,7 +329,7 @@ struct SweepingTest {
             //window.draw(idText);
         }
 
-        for (const auto& vert : algorithm.voronoiVertices) {
+        for (const auto& vert : algorithm.voronoi.vertices()) {
             auto v = sf::CircleShape(2);
             v.setPosition(vert.x - 2, vert.y - 2);
             v.setFillColor(sf::Color::Green);
@@ -330,12 +344,12 @@ struct SweepingTest {
         //    window.draw(v);
         //}
 
-        for (const auto& ev : algorithm.events) {
+        for (const auto& ev : algorithm.eventQueue.vertexEvents()) {
             if (ev.y <= sweepLineY) continue;
-            if (ev.type == tora::sim::fortune::Event::VERTEX && ev.active) {
+            if (tora::sim::fortune::EventQueue::isLive(ev)) {
                 auto evl = sf::RectangleShape(sf::Vector2f(800, 2));
                 evl.setPosition(0, ev.y);
-                evl.setFillColor(ev.active ? sf::Color(180, 120, 255) : sf::Color(200, 200, 200));
+                evl.setFillColor(sf::Color(180, 120, 255));
                 window.draw(evl);
             }
         }
@@ -365,22 +379,6 @@ struct SweepingTest {
                 });
         }
 
-        // draw boundary circle
-        const double pi = 3.14159265;
-        int numSides = 12;
-        double step = 2 * pi / numSides;
-        double radius = 650;
-        sf::Vector2 origin(400, 400);
-        double theta = 0;
-        for (int i = 0; i < numSides; i++, theta += step) {
-            double x = cos(theta) * radius + origin.x;
-            double y = sin(theta) * radius + origin.y;
-            sites.push_back(tora::sim::fortune::Site{
-                .id = 0,
-                .location = tora::sim::fortune::Point(x, y)
-            });
-        }
-
         std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) {
             return a.location.y < b.location.y;
             });
@@ -398,21 +396,23 @@ struct SweepingTest {
 };
 
 struct DivisionTest {
-    tora::sim::fortune::State algorithm;
-    std::vector<tora::geometry::Polygon> polygons;
-
-    DivisionTest(const std::vector<tora::sim::fortune::Site>& sites) : algorithm{ sites } {
-        algorithm.run();
-        auto voronoiPolygons = algorithm.getPolygons();
-        for (const auto& p : voronoiPolygons) {
-            polygons.push_back(tora::geometry::offset(p, -8.0));
-        }
+    std::vector<tora::sim::fortune::Site> sites;
+    tora::sim::VoronoiEngine engine;
+    tora::geometry::PolygonIndex polygons;
+
+    DivisionTest(const std::vector<tora::sim::fortune::Site>& sites, tora::sim::VoronoiEngine engine = tora::sim::VoronoiEngine::Fortune)
+        : sites{ sites }, engine{ engine } {
+        auto voronoiPolygons = tora::sim::fortune::toPolygons(tora::sim::computeCells(engine, sites, siteBoundary()));
+        tora::geometry::PolygonSet blocks;
+        const double amount = -8.0;
+        tora::geometry::offsetBatch(voronoiPolygons, { &amount, 1 }, blocks);
+        polygons = tora::geometry::PolygonIndex(std::move(blocks));
     }
 
-    void renderPolygon(sf::RenderWindow& window, const auto& polygon, sf::Color lineColor) {
-        for (int i = 0; i < polygon.vertices.size(); i++) {
-            auto v1 = polygon.vertices[i];
-            auto v2 = polygon.vertices[(i + 1) % polygon.vertices.size()];
+    void renderPolygon(sf::RenderWindow& window, tora::geometry::PolygonView polygon, sf::Color lineColor) {
+        for (int i = 0; i < polygon.size(); i++) {
+            auto v1 = polygon[i];
+            auto v2 = polygon[(i + 1) % polygon.size()];
             sf::Vertex line[2];
             line[0].position = sf::Vector2f(v1.x, v1.y);
             line[0].color = lineColor;
@@ -427,29 +427,21 @@ struct DivisionTest {
         auto mousePoint = tora::geometry::Point(mouse.x, mouse.y);
         auto siteCloseToMouseId = -1;
 
-        for (const auto& site : algorithm.sites) {
+        for (const auto& site : sites) {
             auto v = sf::CircleShape(3);
             v.setPosition(site.location.x - 3, site.location.y - 3);
             v.setFillColor(sf::Color::White);
             window.draw(v);
         }
 
-        for (const auto& polygon : polygons) {
-            if (polygon.contains(mousePoint)) {
-                // renderPolygon(window, polygon, sf::Color::Green);
-            }
-            else {
-                renderPolygon(window, polygon, sf::Color::White);
+        int hovered = polygons.find(mousePoint);
+        for (int i = 0; i < polygons.size(); i++) {
+            if (i != hovered) {
+                renderPolygon(window, polygons.polygon(i), sf::Color::White);
             }
         }
-
-        for (const auto& polygon : polygons) {
-            if (polygon.contains(mousePoint)) {
-                renderPolygon(window, polygon, sf::Color::Green);
-            }
-            else {
-                // renderPolygon(window, polygon, sf::Color::White);
-            }
+        if (hovered >= 0) {
+            renderPolygon(window, polygons.polygon(hovered), sf::Color::Green);
         }
     }
 
@@ -467,22 +459,6 @@ struct DivisionTest {
                 });
         }
 
-        // draw boundary circle
-        const double pi = 3.14159265;
-        int numSides = 12;
-        double step = 2 * pi / numSides;
-        double radius = 650;
-        sf::Vector2 origin(400, 400);
-        double theta = 0;
-        for (int i = 0; i < numSides; i++, theta += step) {
-            double x = cos(theta) * radius + origin.x;
-            double y = sin(theta) * radius + origin.y;
-            sites.push_back(tora::sim::fortune::Site{
-                .id = 0,
-                .location = tora::sim::fortune::Point(x, y)
-                });
-        }
-
         std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) {
             return a.location.y < b.location.y;
             });
@@ -630,6 +606,16 @@ int main(int argc, char** argv) {
                     // pst = PolygonShrinkTest::create(7);
                 }
 
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
+                {
+                    // same sites through the other Voronoi engine
+                    auto engine = dt.engine == tora::sim::VoronoiEngine::Fortune
+                        ? tora::sim::VoronoiEngine::Delaunay
+                        : tora::sim::VoronoiEngine::Fortune;
+                    dt = DivisionTest{ dt.sites, engine };
+                    std::cout << "Voronoi engine: " << tora::sim::engineName(engine) << "\n";
+                }
+
                 if (sf::Keyboard::isKeyPressed(sf::Keyboard::R))
                 {
                     // st = SweepingTest::reset(st);